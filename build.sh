@@ -1,2 +1,17 @@
-g++ main.cpp -lsfml-window -lsfml-system -lsfml-graphics
+g++ ssembed.cpp -o ssembed
+./ssembed ssgui_assets.hpp \
+    buttonTexture=./buttonTexture.png \
+    vsliderTexture=./vsliderTexture.png \
+    hsliderTexture=./hsliderTexture.png \
+    knobTexture=./knobTexture.png \
+    freeSans=./FreeSans.otf
+g++ main.cpp -DSSGUI_EMBEDDED_ASSETS -lsfml-window -lsfml-system -lsfml-graphics
+g++ sspack.cpp -o sspack -lsfml-window -lsfml-system -lsfml-graphics
 
+g++ ssbench.cpp -o ssbench -lsfml-window -lsfml-system -lsfml-graphics
+g++ sscheck.cpp -o sscheck -lsfml-window -lsfml-system -lsfml-graphics
+if [ -n "$DISPLAY" ]; then
+    ./sscheck
+else
+    ./sscheck --no-gpu  # Textures need an OpenGL context
+fi
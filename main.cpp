@@ -3,6 +3,14 @@
 #define SSGUI_IMPL
 #include "ssgui.hpp"
 
+// build.sh embeds assets to ssgui_assets.hpp, so the binary reads no files
+#ifdef SSGUI_EMBEDDED_ASSETS
+    #include "ssgui_assets.hpp"
+    #define ASSET(name, path) ss::assets::name, sizeof(ss::assets::name)
+#else
+    #define ASSET(name, path) path
+#endif
+
 // Hi! It is near real-world ssgui usage example
 
 
@@ -13,12 +21,15 @@ int main()  // Maybe too much maybe boilerplate code, but maybe still ok...
     sf::Texture vsliderTexture;
     sf::Texture hsliderTexture;
     sf::Texture knobTexture;
+    sf::Font font;
 
-    // Loading resources
-    assert(buttonTexture.loadFromFile("./buttonTexture.png"));
-    assert(vsliderTexture.loadFromFile("./vsliderTexture.png"));
-    assert(hsliderTexture.loadFromFile("./hsliderTexture.png"));
-    assert(knobTexture.loadFromFile("./knobTexture.png"));
+    // Loading resources in background, widgets are drawn as placeholders
+    // until their textures are ready
+    ss::ResourceLoader loader;
+    loader.load(vsliderTexture, ASSET(vsliderTexture, "./vsliderTexture.png"));
+    loader.load(hsliderTexture, ASSET(hsliderTexture, "./hsliderTexture.png"));
+    loader.load(knobTexture, ASSET(knobTexture, "./knobTexture.png"));
+    loader.load(font, ASSET(freeSans, "./FreeSans.otf"));
 
     // Creating sprites
     sf::Sprite 
@@ -35,9 +46,6 @@ int main()  // Maybe too much maybe boilerplate code, but maybe still ok...
     sf::CircleShape knobCircleShape;
     knobCircleShape.setRadius(50);
 
-    sf::Font font;
-    assert(font.loadFromFile("./FreeSans.otf"));
-
     // Constructing our awesome widgets
     ss::Button button(idleButton, hoverButton, hitButton);
     ss::Slider vslider(sf::RectangleShape(sf::Vector2f(25, 200)),
@@ -50,44 +58,32 @@ int main()  // Maybe too much maybe boilerplate code, but maybe still ok...
 
     // Preparation: settings the right position...
     button.setPosition(200, 100);
+    loader.load(buttonTexture, ASSET(buttonTexture, "./buttonTexture.png"),
+                [&]
+                {
+                    if (ss::loaded(&buttonTexture))  // Not if it has failed
+                        button.setHitMask(ss::HitMask::of(buttonTexture));
+                });
     vslider.setPosition(400, 300);
     hslider.setPosition(200, 200);
     lineEdit.setPosition(200, 400);
     knob.setPosition(300, 300);
 
-    sf::RenderWindow window(sf::VideoMode(640, 480), "SSGUI is alive...");
-
-    while (window.isOpen())  // Main application loop
-    {
-        sf::Event event;
-        while (window.pollEvent(event))  // Event handling loop
-        {
-            if (event.type == sf::Event::Closed)
-                window.close();
+    // Gui dispatches events to widgets, updates and draws them
+    ss::Gui gui;
+    gui.add(button);
+    gui.add(vslider);
+    gui.add(hslider);
+    gui.add(lineEdit);
+    gui.add(knob);
 
-            // Awesome widgets should process some events to be happy
-            button.handleEvent(event);
-            vslider.handleEvent(event);
-            hslider.handleEvent(event);
-            lineEdit.handleEvent(event);
-            knob.handleEvent(event);
-        }
-        
-        // Updating our awesome widgets
-        button.update(window);
-        vslider.update(window);
-        hslider.update(window);
-        lineEdit.update(window);
-        knob.update(window);
+    sf::RenderWindow window(sf::VideoMode(640, 480), "SSGUI is alive...");
 
-        // Drawing our awesome widgets
-        window.clear(sf::Color(26, 26, 29));  // Clear with nice gray color
-        window.draw(button);
-        window.draw(vslider);
-        window.draw(hslider);
-        window.draw(lineEdit);
-        window.draw(knob);
-        window.display();
-    }
+    // Main application loop: handles events, updates and draws our
+    // awesome widgets, sleeps while nothing happens
+    ss::Application app(window, gui);
+    app.setResourceLoader(&loader);  // Uploads loaded textures
+    app.setClearColor(sf::Color(26, 26, 29));  // Clear with nice gray color
+    app.run();
 }
 
@@ -0,0 +1,121 @@
+#include <SFML/Graphics/RenderTexture.hpp>
+
+#define SSGUI_IMPL
+#include "ssgui.hpp"
+
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+
+// ssbench - virtual calls through ss::AbstractWidget pointers against
+// statically dispatched ss::WidgetSet loops, for updates, events and draws
+// Usage: ssbench [widget count] [frames]
+
+
+namespace
+{
+    void report(const char* what, sf::Time virtualTime, sf::Time setTime,
+                unsigned long frames)
+    {
+        const auto perFrame = [frames](sf::Time time)
+            { return time.asMicroseconds() / static_cast<double>(frames); };
+        std::cout << what << ": virtual " << perFrame(virtualTime)
+                  << " us, ss::WidgetSet " << perFrame(setTime)
+                  << " us per frame" << std::endl;
+    }
+}
+
+
+int main(int argc, char** argv)
+{
+    const auto count = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 10000;
+    const auto frames = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 200;
+    if (count == 0 or frames == 0)
+    {
+        std::cerr << "Usage: " << argv[0] << " [widget count] [frames]"
+                  << std::endl;
+        return 1;
+    }
+
+    sf::Texture buttonTexture;
+    sf::Texture knobTexture;
+    buttonTexture.create(64, 96);
+    knobTexture.create(32, 32*16);
+    const sf::Sprite idle(buttonTexture, sf::IntRect(0, 0, 64, 32));
+    const sf::Sprite hover(buttonTexture, sf::IntRect(0, 32, 64, 32));
+    const sf::Sprite hit(buttonTexture, sf::IntRect(0, 64, 64, 32));
+    const sf::Sprite knobSheet(knobTexture);
+
+    // The same buttons and knobs: allocated one by one and called through
+    // base pointers as a gui does, and stored by value in a set
+    std::vector<std::unique_ptr<ss::AbstractWidget>> widgets;
+    ss::WidgetSet<ss::Button, ss::Knob> set;
+    for (unsigned long i = 0; i < count; ++i)
+    {
+        const sf::Vector2f position(16.f + 40*(i % 20),
+                                    16.f + 40*(i / 20 % 15));
+        if (i % 2 == 0)
+        {
+            widgets.push_back(std::make_unique<ss::Button>(idle, hover, hit));
+            set.add(ss::Button(idle, hover, hit));
+            set.widgets<ss::Button>().back().setPosition(position);
+        }
+        else
+        {
+            widgets.push_back(std::make_unique<ss::Knob>(
+                sf::CircleShape(16.f), knobSheet));
+            set.add(ss::Knob(sf::CircleShape(16.f), knobSheet));
+            set.widgets<ss::Knob>().back().setPosition(position);
+        }
+        widgets.back()->setPosition(position);
+    }
+
+    const sf::Window window;  // Widgets don't use it
+    sf::RenderTexture target;
+    if (not target.create(800, 600))
+        return 1;
+
+    sf::Event moved;
+    moved.type = sf::Event::MouseMoved;
+
+    sf::Time virtualTimes[3] = {sf::Time::Zero, sf::Time::Zero,
+                                sf::Time::Zero};
+    sf::Time setTimes[3] = {sf::Time::Zero, sf::Time::Zero, sf::Time::Zero};
+    sf::Clock clock;
+    for (unsigned long frame = 0; frame < frames; ++frame)
+    {
+        moved.mouseMove.x = static_cast<int>(frame*7 % 800);
+        moved.mouseMove.y = static_cast<int>(frame*3 % 600);
+
+        clock.restart();
+        for (const auto& widget : widgets)
+            widget->handleEvent(moved);
+        virtualTimes[0] += clock.restart();
+        set.handleEvent(moved);
+        setTimes[0] += clock.restart();
+
+        for (const auto& widget : widgets)
+            widget->update(window);
+        virtualTimes[1] += clock.restart();
+        set.update(window);
+        setTimes[1] += clock.restart();
+
+        // CPU time of submitting draws, display() flushes them
+        target.clear();
+        target.display();
+        clock.restart();
+        for (const auto& widget : widgets)
+            target.draw(*widget);
+        target.display();
+        virtualTimes[2] += clock.restart();
+        target.draw(set);
+        target.display();
+        setTimes[2] += clock.restart();
+    }
+
+    std::cout << count << " widgets, " << frames << " frames" << std::endl;
+    report("handleEvent", virtualTimes[0], setTimes[0], frames);
+    report("update", virtualTimes[1], setTimes[1], frames);
+    report("draw", virtualTimes[2], setTimes[2], frames);
+    return 0;
+}
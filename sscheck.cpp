@@ -0,0 +1,736 @@
+#define SSGUI_IMPL
+#include "ssgui.hpp"
+
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <new>
+#include <random>
+
+// sscheck - checks of ssgui that need no window, build.sh runs it
+// Usage: sscheck [--no-gpu] (exit code is not zero if some check has failed)
+// Checks of textures need an OpenGL context (a display on linux),
+// --no-gpu skips them
+
+
+namespace
+{
+    std::size_t allocations = 0;  // Calls of the global operator new
+    int failures = 0;
+
+    void check(bool passed, const std::string& what)
+    {
+        std::cout << (passed ? "ok      " : "FAILED  ") << what << std::endl;
+        if (not passed)
+            ++failures;
+    }
+
+    sf::Event mouseMoved(int x, int y)
+    {
+        sf::Event event;
+        event.type = sf::Event::MouseMoved;
+        event.mouseMove.x = x;
+        event.mouseMove.y = y;
+        return event;
+    }
+
+    sf::Event mouseButton(sf::Event::EventType type, int x, int y)
+    {
+        sf::Event event;
+        event.type = type;
+        event.mouseButton.button = sf::Mouse::Left;
+        event.mouseButton.x = x;
+        event.mouseButton.y = y;
+        return event;
+    }
+
+    // Frame of a gui as a main loop does it, the cursor goes around
+    // the widgets and presses some of them. Frames repeat every 64
+    void frame(ss::Gui& gui, const sf::Window& window, unsigned index)
+    {
+        const int x = static_cast<int>(index*37 % 640);
+        const int y = static_cast<int>(index*23 % 480);
+        for (int step = 0; step < 4; ++step)
+            gui.handleEvent(mouseMoved(x + step*5, y + step*3));
+        if (index % 8 == 0)
+            gui.handleEvent(mouseButton(sf::Event::MouseButtonPressed, x, y));
+        if (index % 8 == 3)
+            gui.handleEvent(mouseButton(sf::Event::MouseButtonReleased,
+                                        x, y));
+        gui.update(window);
+    }
+
+    // Once vectors of the gui have grown, frames allocate nothing
+    void checkSteadyFrames(sf::Time budget)
+    {
+        const sf::Texture texture;  // Widgets are drawn as placeholders
+        const sf::Window window;  // Never opened, widgets don't use it
+
+        std::vector<ss::Button> buttons(40, ss::Button(
+            sf::Sprite(texture, sf::IntRect(0, 0, 60, 30)),
+            sf::Sprite(texture, sf::IntRect(0, 30, 60, 30)),
+            sf::Sprite(texture, sf::IntRect(0, 60, 60, 30))));
+        ss::Knob knob(sf::CircleShape(40.f),
+                      sf::Sprite(texture, sf::IntRect(0, 0, 80, 800)));
+        ss::Slider slider(sf::RectangleShape(sf::Vector2f(20.f, 200.f)),
+                          sf::Sprite(texture, sf::IntRect(0, 0, 20, 2000)),
+                          ss::Vertical);
+
+        ss::Gui gui;
+        gui.setUpdateBudget(budget);
+        for (std::size_t i = 0; i < buttons.size(); ++i)
+        {
+            buttons[i].setPosition(40.f + 70*(i % 8), 20.f + 40*(i / 8));
+            gui.add(buttons[i]);
+        }
+        knob.setPosition(560.f, 300.f);
+        gui.add(knob);
+        slider.setPosition(300.f, 360.f);
+        gui.add(slider);
+
+        for (unsigned i = 0; i < 64; ++i)
+            frame(gui, window, i);
+
+        // Nothing resets the frame arena here, gui itself should not use it
+        const auto before = allocations;
+        for (unsigned i = 64; i < 64*4; ++i)
+            frame(gui, window, i);
+        const auto frameAllocations = allocations - before;
+
+        const auto name = "update budget "
+            + std::to_string(budget.asMicroseconds()) + " us";
+        check(frameAllocations == 0, "no allocations in steady frames, "
+              + name);
+        check(gui.frameArena().capacity() == 0,
+              "gui without ss::Application leaves frame arena empty, "
+              + name);
+    }
+
+    // Vectorized hit tests agree with the scalar ones, edges included
+    void checkHitMaskParity()
+    {
+        std::mt19937 random(2024);
+        std::uniform_real_distribution<float> coordinate(-50.f, 850.f);
+        std::uniform_real_distribution<float> extent(-20.f, 200.f);
+
+        // Not a multiple of SimdWidth, so padding is tested too
+        ss::RectBatch rects;
+        ss::EllipseBatch ellipses;
+        std::vector<sf::Vector2f> points;
+        for (int i = 0; i < 203; ++i)
+        {
+            const sf::FloatRect rect(coordinate(random), coordinate(random),
+                                     extent(random), extent(random));
+            rects.push(rect);
+            ellipses.push(ss::Ellipse{
+                sf::Vector2f(rect.left, rect.top),
+                i % 17 ? sf::Vector2f(std::abs(rect.width),
+                                      std::abs(rect.height))
+                       : sf::Vector2f()});
+            points.emplace_back(rect.left, rect.top);
+            points.emplace_back(rect.left + rect.width,
+                                rect.top + rect.height);
+        }
+        for (int i = 0; i < 2000; ++i)
+            points.emplace_back(coordinate(random), coordinate(random));
+
+        const auto compare = [&points](const auto& batch)
+        {
+            ss::RectBatch::Mask simd, scalar;
+            for (auto point : points)
+            {
+                batch.hitMask(point, simd);
+                batch.hitMaskScalar(point, scalar);
+                if (simd != scalar)
+                    return false;
+            }
+            return true;
+        };
+        check(compare(rects), "ss::RectBatch SIMD and scalar masks match");
+        check(compare(ellipses),
+              "ss::EllipseBatch SIMD and scalar masks match");
+
+        for (std::size_t i = 0; i < 60; ++i)
+        {
+            rects.erase(i*3 % rects.size());
+            ellipses.erase(i*5 % ellipses.size());
+        }
+        check(compare(rects) and compare(ellipses),
+              "SIMD and scalar masks match after erase");
+    }
+
+    // Handle of a destroyed widget stays dead when it's slot is reused,
+    // and a callback may destroy it's own widget in the middle of an event
+    void checkWidgetStoreHandles()
+    {
+        const sf::Texture texture;  // Widgets are drawn as placeholders
+        const sf::Window window;
+        const ss::ButtonSkin skin(texture, sf::IntRect(0, 0, 60, 30),
+                                  sf::IntRect(0, 30, 60, 30),
+                                  sf::IntRect(0, 60, 60, 30));
+
+        ss::WidgetStore store;
+        const auto old = store.createButton(skin).handle();
+        store.destroy(old);
+        auto button = store.createButton(skin);
+        const auto handle = button.handle();
+        check(handle.index == old.index and not store.alive(old)
+              and store.alive(handle) and store.size() == 1,
+              "widget store slot is reused under a new generation");
+
+        // Callback holds the token, it is released with the widget
+        const auto token = std::make_shared<int>(0);
+        button.setPosition(100.f, 100.f);
+        button.bind(ss::Hit, [&store, handle, token]()
+        {
+            ++*token;
+            store.destroy(handle);
+        });
+        store.update(window);
+        store.handleEvent(mouseMoved(100, 100));
+        store.handleEvent(mouseButton(sf::Event::MouseButtonPressed,
+                                      100, 100));
+        store.handleEvent(mouseMoved(300, 300));
+        store.handleEvent(mouseButton(sf::Event::MouseButtonReleased,
+                                      300, 300));
+        store.update(window);
+        const bool destroyed = *token == 1 and token.use_count() == 1
+            and not store.alive(handle) and store.size() == 0
+            and not store.grabsMouse();
+
+        // Widget in the same slot doesn't inherit the state or capture
+        auto next = store.createButton(skin);
+        next.setPosition(100.f, 100.f);
+        store.update(window);
+        check(destroyed and next.handle().index == handle.index
+              and next.state() == ss::Idle and not store.grabsMouse(),
+              "widget destroyed by it's own callback leaves a clean slot");
+    }
+
+    // Captured widget of a set stays captured when widgets before it are
+    // erased, and the capture is dropped when it can't be found anymore
+    void checkWidgetSetCapture()
+    {
+        const sf::Texture texture;
+        const sf::Window window;
+        const ss::Button button(
+            sf::Sprite(texture, sf::IntRect(0, 0, 60, 30)),
+            sf::Sprite(texture, sf::IntRect(0, 30, 60, 30)),
+            sf::Sprite(texture, sf::IntRect(0, 60, 60, 30)));
+
+        ss::WidgetSet<ss::Button, ss::Knob> set;
+        for (int i = 0; i < 3; ++i)
+            set.add(button).setPosition(100.f + 100*i, 100.f);
+        set.add(ss::Knob(sf::CircleShape(40.f),
+                         sf::Sprite(texture, sf::IntRect(0, 0, 80, 800))))
+            .setPosition(500.f, 300.f);
+        set.update(window);  // Collision shapes are placed
+        const auto press = [&set](int x, int y)
+        {
+            set.handleEvent(mouseMoved(x, y));
+            set.handleEvent(mouseButton(sf::Event::MouseButtonPressed, x, y));
+        };
+        const auto& buttons = set.widgets<ss::Button>();
+
+        press(300, 100);
+        set.erase<ss::Button>(0);
+        set.update(window);
+        check(set.grabsMouse() and buttons.size() == 2
+              and buttons[1].state() == ss::Hit,
+              "widget set keeps the capture when a widget before it is"
+              " erased");
+
+        set.erase<ss::Button>(1);
+        set.update(window);
+        check(not set.grabsMouse(),
+              "widget set releases the mouse when the captured widget is"
+              " erased");
+
+        set.add(button).setPosition(100.f, 100.f);
+        set.update(window);
+        press(100, 100);
+        auto& behind = set.widgets<ss::Button>();  // Not through the set
+        behind.erase(behind.begin());
+        set.handleEvent(mouseMoved(100, 100));
+        check(not set.grabsMouse(),
+              "widget set releases the mouse when widgets are erased"
+              " behind it");
+    }
+
+    // Polygon contains the points of it's edges and vertices, and it's
+    // cached edge equations follow the transform
+    void checkPolygonContainment()
+    {
+        ss::ConvexPolygon square({{0.f, 0.f}, {10.f, 0.f}, {10.f, 10.f},
+                                  {0.f, 10.f}});
+        const auto boundary = [](const auto& shape, sf::Vector2f min,
+                                 sf::Vector2f max)
+        {
+            const auto middle = (min + max) / 2.f;
+            return shape.contains(min) and shape.contains(max)
+                and shape.contains({max.x, min.y})
+                and shape.contains({min.x, middle.y})
+                and shape.contains({middle.x, max.y})
+                and not shape.contains({max.x + 0.5f, middle.y})
+                and not shape.contains({middle.x, min.y - 0.5f});
+        };
+        const bool still = boundary(square, {0.f, 0.f}, {10.f, 10.f});
+
+        square.setPosition(100.f, 0.f);
+        const bool moved = boundary(square, {100.f, 0.f}, {110.f, 10.f})
+            and not square.contains({5.f, 5.f});
+        square.setScale(-2.f, 1.f);  // Mirrored: the points turn around
+        const bool mirrored = boundary(square, {80.f, 0.f}, {100.f, 10.f})
+            and not square.contains({105.f, 5.f});
+        check(still and moved and mirrored,
+              "polygon contains it's edges and vertices as it is"
+              " transformed");
+
+        // Triangle and a rectangle apart, the compound is moved later
+        ss::CompoundShape compound;
+        compound.add(ss::ConvexPolygon({{0.f, 0.f}, {10.f, 0.f},
+                                        {0.f, 10.f}}));
+        compound.add(sf::FloatRect(20.f, 0.f, 10.f, 10.f));
+        const auto shape = [&compound, &boundary](float dx)
+        {
+            return boundary(compound, {20.f + dx, 0.f}, {30.f + dx, 10.f})
+                and compound.contains({dx, 10.f})
+                and compound.contains({5.f + dx, 5.f})
+                and not compound.contains({6.f + dx, 6.f})
+                and not compound.contains({15.f + dx, 5.f});
+        };
+        const bool placed = shape(0.f);
+        compound.setPosition(50.f, 0.f);
+        check(placed and shape(50.f) and not compound.contains({25.f, 5.f}),
+              "compound shape contains edges and vertices as it is moved");
+    }
+
+    // Corners of a nine-slice skin keep their size (times the scale),
+    // edges and the center stretch, corners shrink to fit a small area
+    void checkNineSlice()
+    {
+        const sf::IntRect rect(0, 0, 30, 30);
+        const ss::ButtonSkin::Insets insets{10, 10, 10, 10};
+        std::array<sf::Vertex, 36> quads;
+        const auto sizes = [&quads](unsigned quad)
+        {
+            const auto first = &quads[quad*4];
+            return std::make_pair(first[2].position - first[0].position,
+                                  first[2].texCoords - first[0].texCoords);
+        };
+        const auto layout = [&](sf::Vector2f max, sf::Vector2f scale,
+                                sf::Vector2f corner, sf::Vector2f center)
+        {
+            ss::detail::nineSlice(quads.data(), {0.f, 0.f}, max, rect,
+                                  insets, scale, sf::Color::White);
+            const sf::Vector2f texture(10.f, 10.f);
+            bool same = quads[34].position == max;  // Far corner
+            for (unsigned quad : {0, 2, 6, 8})
+                same = same and sizes(quad)
+                    == std::make_pair(corner, texture);
+            return same and sizes(1) == std::make_pair(
+                    sf::Vector2f(center.x, corner.y), texture)
+                and sizes(3) == std::make_pair(
+                    sf::Vector2f(corner.x, center.y), texture)
+                and sizes(4) == std::make_pair(center, texture);
+        };
+
+        check(layout({100.f, 60.f}, {1.f, 1.f}, {10.f, 10.f}, {80.f, 40.f})
+              and layout({100.f, 60.f}, {2.f, 1.f},
+                         {20.f, 10.f}, {60.f, 40.f}),
+              "nine-slice corners keep their size, edges and center"
+              " stretch");
+        check(layout({12.f, 60.f}, {1.f, 1.f}, {6.f, 10.f}, {0.f, 40.f})
+              and layout({0.f, 0.f}, {1.f, 1.f}, {0.f, 0.f}, {0.f, 0.f}),
+              "nine-slice corners shrink to an area smaller than them");
+    }
+
+    // Allocations are aligned, a frame like the previous one reuses
+    // the blocks and makes no heap allocations
+    void checkFrameArena()
+    {
+        ss::FrameArena arena(1024);
+        const auto oneFrame = [&arena]()
+        {
+            bool aligned = true;
+            for (std::size_t size = 1; size < 200; size += 7)
+            {
+                const std::size_t alignment = std::size_t(1) << size % 5;
+                const auto address = reinterpret_cast<std::uintptr_t>(
+                    arena.allocate(size, alignment));
+                aligned = aligned and address % alignment == 0;
+            }
+            arena.allocate(4096, 64);  // Larger than a block
+
+            ss::FrameVector<int> numbers{ss::FrameAllocator<int>(arena)};
+            for (int i = 0; i < 300; ++i)
+                numbers.push_back(i);
+            return aligned;
+        };
+
+        auto before = allocations;
+        const bool aligned = oneFrame();
+        const auto firstAllocations = allocations - before;
+        const auto used = arena.used();
+        const auto capacity = arena.capacity();
+
+        arena.reset();
+        const auto usedAfterReset = arena.used();
+        before = allocations;
+        oneFrame();
+        const auto secondAllocations = allocations - before;
+
+        check(aligned, "frame arena aligns allocations");
+        check(used >= 4096 + 300*sizeof(int) and capacity >= used,
+              "frame arena counts used bytes");
+        check(usedAfterReset == 0, "frame arena reset frees everything");
+        check(firstAllocations > 0 and secondAllocations == 0,
+              "frame arena reuses it's blocks after reset");
+        check(arena.used() == used and arena.capacity() == capacity,
+              "frame arena is used the same way by the same frame");
+    }
+
+    std::vector<char> readBytes(const std::string& path)
+    {
+        std::ifstream file(path, std::ios::binary);
+        return std::vector<char>(std::istreambuf_iterator<char>(file),
+                                 std::istreambuf_iterator<char>());
+    }
+
+    bool writeBytes(const std::string& path, const std::vector<char>& bytes)
+    {
+        std::ofstream file(path, std::ios::binary);
+        file.write(bytes.data(), bytes.size());
+        return static_cast<bool>(file);
+    }
+
+    // Pack written by savePack is loaded with the same rectangles, frames,
+    // pixels and masks as build() makes, broken packs are rejected
+    void checkPackRoundTrip()
+    {
+        // Strip of three square frames with a transparent corner in each
+        // and pixels at both sides of the mask threshold, and a plain image
+        sf::Image strip;
+        strip.create(6, 18, sf::Color::Transparent);
+        for (unsigned y = 0; y < 18; ++y)
+            for (unsigned x = 0; x < 6; ++x)
+                if (x != 0 or y % 6 != 0)
+                    strip.setPixel(x, y, sf::Color(y/6*80, 10, 200 - x));
+        strip.setPixel(5, 0, sf::Color(40, 10, 195, ss::HitMaskAlphaThreshold));
+        strip.setPixel(5, 1,
+                       sf::Color(40, 10, 195, ss::HitMaskAlphaThreshold - 1));
+        sf::Image plain;
+        plain.create(5, 3, sf::Color::Red);
+
+        const std::string stripPath = "sscheck_strip.png";
+        const std::string plainPath = "sscheck_plain.png";
+        const std::string packPath = "sscheck.sspack";
+        const std::string brokenPath = "sscheck_broken.sspack";
+        if (not strip.saveToFile(stripPath) or not plain.saveToFile(plainPath))
+        {
+            check(false, "images for the pack round trip are written");
+            return;
+        }
+
+        ss::Atlas built;
+        built.add("strip", stripPath);
+        built.add("plain", plainPath);
+        const bool saved = built.savePack(packPath, 1);
+        const bool buildOk = built.build(1);
+
+        ss::Atlas loaded;
+        const bool loadOk = loaded.loadPack(packPath);
+        check(saved and buildOk and loadOk, "pack is saved and loaded");
+
+        bool same = loadOk and loaded.pageCount() == built.pageCount();
+        for (const auto& [name, image] :
+             {std::make_pair("strip", &strip), std::make_pair("plain", &plain)})
+        {
+            if (not same or not loaded.contains(name))
+            {
+                same = false;
+                break;
+            }
+            const auto sprite = loaded.sprite(name);
+            const auto rect = sprite.getTextureRect();
+            const auto mask = loaded.hitMask(name);
+            same = same and rect == built.sprite(name).getTextureRect()
+                and loaded.frames(name) == built.frames(name)
+                and sprite.getTexture() and mask
+                and rect.width == static_cast<int>(image->getSize().x)
+                and rect.height == static_cast<int>(image->getSize().y);
+            if (not same)
+                break;
+
+            const auto page = sprite.getTexture()->copyToImage();
+            for (int y = 0; y < rect.height; ++y)
+                for (int x = 0; x < rect.width; ++x)
+                {
+                    const auto pixel = image->getPixel(x, y);
+                    same = same
+                        and page.getPixel(rect.left + x, rect.top + y)
+                            == pixel
+                        and mask->opaque(rect.left + x, rect.top + y)
+                            == (pixel.a >= ss::HitMaskAlphaThreshold);
+                }
+        }
+        check(same, "loaded pack has the built rectangles, frames, pixels"
+                    " and masks");
+        check(loadOk and loaded.frames("strip") == 3,
+              "frames of a strip survive the pack");
+
+        // Page table: u32 width at 16, entry table: i32 left at 16+24n+4
+        const auto bytes = readBytes(packPath);
+        const auto corrupt = [&](std::size_t at, std::uint32_t value)
+        {
+            auto broken = bytes;
+            for (int i = 0; i < 4; ++i)
+                broken[at + i] = static_cast<char>(value >> i*8);
+            ss::Atlas atlas;
+            return writeBytes(brokenPath, broken)
+                and not atlas.loadPack(brokenPath);
+        };
+        const auto entries = 16 + 24*built.pageCount();
+        check(bytes.size() > entries + 8
+              and corrupt(16, 0x7fffffff) and corrupt(16, 0)
+              and corrupt(entries + 4, 0x7ffffff0),
+              "packs with oversized pages or entries out of pages are"
+              " rejected");
+
+        for (const auto& path : {stripPath, plainPath, packPath, brokenPath})
+            std::remove(path.c_str());
+    }
+
+    // Frames are trimmed to their opaque pixels, identical ones share
+    // a rectangle, and rectangles put at their offsets give the sheet back
+    void checkCompactSheet()
+    {
+        // Four 8x8 frames: a block, the same block moved, nothing and
+        // a different block
+        sf::Image sheet;
+        sheet.create(8, 32, sf::Color::Transparent);
+        const auto fill = [&sheet](unsigned frame, sf::IntRect rect,
+                                   sf::Color color)
+        {
+            for (int y = 0; y < rect.height; ++y)
+                for (int x = 0; x < rect.width; ++x)
+                    sheet.setPixel(rect.left + x, frame*8 + rect.top + y,
+                                   sf::Color(color.r + x*40, color.g + y*40,
+                                             color.b, color.a));
+        };
+        fill(0, sf::IntRect(2, 3, 3, 2), sf::Color(10, 20, 30));
+        fill(1, sf::IntRect(4, 1, 3, 2), sf::Color(10, 20, 30));
+        fill(3, sf::IntRect(0, 4, 1, 4), sf::Color(200, 50, 90, 140));
+
+        const ss::CompactSheet compact(sheet);
+        const float values[] = {-1.f, -1.f/3, 1.f/3, 1.f};
+        const auto& first = compact.frame(values[0]);
+        const auto& moved = compact.frame(values[1]);
+        const auto& empty = compact.frame(values[2]);
+        const auto& other = compact.frame(values[3]);
+        check(compact.frameCount() == 4 and compact.uniqueCount() == 2
+              and moved.rect == first.rect
+              and first.offset == sf::Vector2i(2, 3)
+              and moved.offset == sf::Vector2i(4, 1)
+              and empty.rect == sf::IntRect(),
+              "compact sheet stores identical frames once");
+        check(first.rect.width == 3 and first.rect.height == 2
+              and other.rect.width == 1 and other.rect.height == 4
+              and other.offset == sf::Vector2i(0, 4),
+              "compact sheet trims frames to their opaque pixels");
+
+        const auto texture = compact.texture().copyToImage();
+        bool placed = true;
+        for (unsigned i = 0; i < 4; ++i)
+        {
+            const auto& frame = compact.frame(values[i]);
+            for (int y = 0; y < 8; ++y)
+                for (int x = 0; x < 8; ++x)
+                {
+                    const auto inside = sf::IntRect(frame.offset,
+                        sf::Vector2i(frame.rect.width, frame.rect.height))
+                        .contains(x, y);
+                    const auto pixel = inside
+                        ? texture.getPixel(frame.rect.left + x
+                                               - frame.offset.x,
+                                           frame.rect.top + y
+                                               - frame.offset.y)
+                        : sf::Color::Transparent;
+                    placed = placed and pixel == sheet.getPixel(x, i*8 + y);
+                }
+        }
+        check(placed, "compact sheet frames at their offsets are the sheet");
+    }
+
+    // Frame already in a slot is not uploaded again, a missing one takes
+    // the slot of the least recently used frame
+    void checkStreamingSheet()
+    {
+        // Six 4x4 frames of their own colours, three slots
+        sf::Image image;
+        image.create(4, 24);
+        for (unsigned y = 0; y < 24; ++y)
+            for (unsigned x = 0; x < 4; ++x)
+                image.setPixel(x, y, sf::Color(y/4*40, 100, 200));
+
+        ss::StreamingSheet sheet(image, 3);
+        const auto value = [](unsigned frame) { return -1.f + frame*0.4f; };
+        const auto shows = [&](sf::IntRect rect, unsigned frame)
+        {
+            const auto texture = sheet.texture().copyToImage();
+            return rect.width == 4
+                and texture.getPixel(0, rect.top) == image.getPixel(0, frame*4)
+                and texture.getPixel(3, rect.top + 3)
+                    == image.getPixel(3, frame*4 + 3);
+        };
+
+        const auto slot0 = sheet.frame(value(0));
+        const auto slot1 = sheet.frame(value(1));
+        const auto slot2 = sheet.frame(value(2));
+        const auto again = sheet.frame(value(0));
+        check(sheet.uploads() == 3 and again == slot0
+              and shows(again, 0),
+              "streaming sheet doesn't upload a frame that is in a slot");
+
+        // Frame 1 is the least recently used, then frame 2, then frame 0
+        const auto third = sheet.frame(value(3));
+        const auto fourth = sheet.frame(value(4));
+        const auto first = sheet.frame(value(0));
+        const auto second = sheet.frame(value(1));
+        check(sheet.uploads() == 6 and third == slot1 and fourth == slot2
+              and first == slot0 and second == slot1
+              and shows(fourth, 4) and shows(second, 1)
+              and shows(first, 0),
+              "streaming sheet evicts the least recently used frame");
+    }
+
+    // Least recently used textures without handles are unloaded over
+    // the budget and get() reloads them in place
+    void checkTextureCacheEviction()
+    {
+        const std::string paths[] = {"sscheck_a.png", "sscheck_b.png",
+                                     "sscheck_c.png"};
+        sf::Image image;
+        image.create(16, 16, sf::Color::White);  // 1 KiB texture
+        for (const auto& path : paths)
+            if (not image.saveToFile(path))
+            {
+                check(false, "images for the texture cache are written");
+                return;
+            }
+
+        ss::TextureCache cache(2*1024 + 512);
+        const auto a = cache.get(paths[0]).get();  // Handles are dropped
+        const auto b = cache.get(paths[1]).get();
+        const bool twoLoaded = cache.loadedCount() == 2
+            and cache.bytes() == 2*1024;
+
+        cache.get(paths[0]);  // Now the second one is least recent
+        const auto c = cache.get(paths[2]).get();
+        check(twoLoaded and cache.loadedCount() == 2
+              and a->getSize().x == 16 and b->getSize().x == 0
+              and c->getSize().x == 16,
+              "texture cache unloads the least recently used texture");
+
+        {
+            const auto held = cache.get(paths[2]);
+            cache.setBudget(0);
+            check(cache.loadedCount() == 1 and held->getSize().x == 16
+                  and a->getSize().x == 0,
+                  "texture cache keeps textures with handles");
+        }
+
+        cache.setBudget(ss::TextureCacheBudget);
+        const auto reloaded = cache.get(paths[1]);
+        check(reloaded.get() == b and b->getSize().x == 16,
+              "texture cache reloads a texture in place");
+
+        for (const auto& path : paths)
+            std::remove(path.c_str());
+    }
+
+    // Texture that has failed to load in background is loaded again
+    // by the next get() instead of waiting for the loader forever
+    void checkTextureCacheFailedLoad()
+    {
+        ss::ResourceLoader loader(1);
+        ss::TextureCache cache;
+        cache.setResourceLoader(&loader);
+
+        const auto wait = [&loader]()
+        {
+            for (int i = 0; i < 1000 and loader.pending() != 0; ++i)
+            {
+                loader.upload();
+                sf::sleep(sf::milliseconds(1));
+            }
+            return loader.pending() == 0;
+        };
+
+        const std::string path = "sscheck_missing.png";
+        cache.get(path);
+        const bool failed = wait() and cache.loadedCount() == 0
+            and cache.bytes() == 0;
+        cache.get(path);
+        const bool retried = loader.pending() == 1;
+        check(failed and retried and wait(),
+              "texture cache retries a texture that has failed to load");
+    }
+}
+
+
+void* operator new(std::size_t size)
+{
+    ++allocations;
+    if (const auto memory = std::malloc(size ? size : 1))
+        return memory;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* memory) noexcept
+{
+    std::free(memory);
+}
+
+void operator delete(void* memory, std::size_t) noexcept
+{
+    std::free(memory);
+}
+
+
+int main(int argc, char** argv)
+{
+    const bool gpu = not (argc > 1 and std::string(argv[1]) == "--no-gpu");
+    if (argc > 2 or (argc == 2 and gpu))
+    {
+        std::cerr << "Usage: " << argv[0] << " [--no-gpu]" << std::endl;
+        return 1;
+    }
+
+    checkSteadyFrames(sf::Time::Zero);
+    checkSteadyFrames(sf::seconds(1.f));
+    checkHitMaskParity();
+    checkPolygonContainment();
+    checkNineSlice();
+    checkWidgetStoreHandles();
+    checkWidgetSetCapture();
+    checkFrameArena();
+    if (gpu)
+    {
+        checkPackRoundTrip();
+        checkCompactSheet();
+        checkStreamingSheet();
+        checkTextureCacheEviction();
+        checkTextureCacheFailedLoad();
+    }
+    else
+    {
+        std::cout << "skipped texture checks (--no-gpu)" << std::endl;
+    }
+
+    std::cout << (failures ? "some checks have failed" : "all checks passed")
+              << std::endl;
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,81 @@
+#include <algorithm>
+#include <cctype>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+// ssembed - turns asset files to byte arrays of a header (see build.sh)
+// Usage: ssembed <output header> <name>=<file>...
+// Every asset is ss::assets::<name>, load it with loadFromMemory or
+// ss::ResourceLoader: loader.load(texture, data, sizeof(data))
+
+
+int main(int argc, char** argv)
+{
+    if (argc < 2)
+    {
+        std::cerr << "Usage: " << argv[0]
+                  << " <output header> <name>=<file>..." << std::endl;
+        return 1;
+    }
+
+    std::ofstream header(argv[1]);
+    header << "// Generated by ssembed, do not edit\n\n"
+           << "#ifndef SSGUI_ASSETS_HPP\n"
+           << "#define SSGUI_ASSETS_HPP\n\n\n"
+           << "namespace ss::assets\n"
+           << "{\n";
+
+    for (int i = 2; i < argc; ++i)
+    {
+        const std::string asset = argv[i];
+        const auto separator = asset.find('=');
+        const auto name = asset.substr(0, separator);
+        const bool identifier = not name.empty()
+            and not std::isdigit(static_cast<unsigned char>(name[0]))
+            and std::all_of(name.begin(), name.end(), [](char c)
+                {
+                    return std::isalnum(static_cast<unsigned char>(c))
+                        or c == '_';
+                });
+        if (separator == std::string::npos or not identifier)
+        {
+            std::cerr << "Expected <name>=<file>: " << asset << std::endl;
+            return 1;
+        }
+
+        const auto path = asset.substr(separator + 1);
+        std::ifstream file(path, std::ios::binary);
+        const std::vector<unsigned char> bytes(
+            (std::istreambuf_iterator<char>(file)),
+            std::istreambuf_iterator<char>());
+        if (bytes.empty())  // Missing file or nothing to load from it
+        {
+            std::cerr << "Can't read " << path << std::endl;
+            return 1;
+        }
+
+        header << (i > 2 ? "\n" : "")
+               << "    // " << path << "\n"
+               << "    inline constexpr unsigned char " << name << "[] = {";
+        const char digits[] = "0123456789abcdef";
+        for (std::size_t j = 0; j < bytes.size(); ++j)
+        {
+            const auto byte = bytes[j];
+            header << (j % 16 ? " " : "\n        ")
+                   << "0x" << digits[byte >> 4] << digits[byte & 0xf] << ",";
+        }
+        header << "\n    };\n";
+    }
+
+    header << "}\n\n"
+           << "#endif  // SSGUI_ASSETS_HPP\n";
+    if (not header)
+    {
+        std::cerr << "Can't write " << argv[1] << std::endl;
+        return 1;
+    }
+    return 0;
+}
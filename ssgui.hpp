@@ -13,6 +13,15 @@
 //      ss::Knob        - dragable or scrollable knob
 //      ss::Slider      - either vertical or horizontal dragable slider
 //      ss::LineEdit    - simple unicode text entry (use of sf::Text/String)
+//      ss::Gui         - widget container with pointer capture for drags
+//      ss::Application - main loop that sleeps while nothing happens
+//      ss::WidgetStore - alternative data-oriented store for thousands
+//                        of plain widgets
+//      ss::WidgetSet   - widgets stored type by type, no virtual calls
+//      ss::MemoryOverlay - memory report of a gui drawn as text
+//      ss::ResourceLoader - background loading of textures and fonts
+//      ss::TextureCache - shared textures by path with a memory budget
+//      ss::Atlas       - skins decoded in parallel and packed to pages
 
 // Feel free to modify it. It is free and open-source.
 // Some widgets are absent.
@@ -22,24 +31,63 @@
 
 // #define SSGUI_IMPL
 
+// Hit tests use SSE/AVX when compiler allows it (-msse2, -mavx...)
+// #define SSGUI_NO_SIMD to use scalar code only
+
 /* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
 
 #ifndef SSGUI_HPP
 #define SSGUI_HPP
 
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <fstream>
 #include <functional>
+#include <iterator>
+#include <limits>
+#include <map>
 #include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <type_traits>
+#include <variant>
+#include <vector>
 
 #include <cassert>
 #include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#if not defined(SSGUI_NO_SIMD) and defined(__AVX__)
+    #define SSGUI_AVX
+    #include <immintrin.h>
+#elif not defined(SSGUI_NO_SIMD) and defined(__SSE2__)
+    #define SSGUI_SSE
+    #include <emmintrin.h>
+#endif
 
 #include <SFML/Graphics/RenderWindow.hpp>
+#include <SFML/Graphics/Image.hpp>
+#include <SFML/Graphics/Texture.hpp>
 #include <SFML/Graphics/Sprite.hpp>
 #include <SFML/Graphics/CircleShape.hpp>
 #include <SFML/Graphics/RectangleShape.hpp>
 #include <SFML/Graphics/Text.hpp>
+#include <SFML/Graphics/Vertex.hpp>
+#include <SFML/Graphics/VertexArray.hpp>
 #include <SFML/Window/Mouse.hpp>
 #include <SFML/Window/Event.hpp>
+#include <SFML/System/Clock.hpp>
+#include <SFML/System/Sleep.hpp>
+#include <SFML/System/Err.hpp>
 
 
 namespace ss  // Interface goes here
@@ -63,23 +111,114 @@ namespace ss  // Interface goes here
     constexpr float KnobScrollSensitivity = 0.1f;
     constexpr float KnobMaxMouseWheelScrollDelta = 0.1f;
     constexpr float KnobMaxMouseMoveDelta = 0.1f;
+    constexpr int ApplicationIdleSleepMs = 10;  // Max sleep between polls
+    constexpr unsigned ApplicationMaxTicksPerFrame = 5;  // Tick catch-up
+    constexpr unsigned GuiBudgetCheckInterval = 32;  // Updates per clock read
+    constexpr std::size_t SimdWidth = 8;  // Floats per batch step (AVX)
+    constexpr std::uint8_t HitMaskAlphaThreshold = 128;  // Opaque from it
+    constexpr std::size_t FrameArenaBlockSize = 64*1024;  // Bytes
+    constexpr int MemoryOverlayRefreshMs = 500;
+    constexpr unsigned ResourceLoaderThreads = 2;
+    constexpr std::size_t ResourceLoaderUploadBytes = 256*1024;  // Per frame
+    inline const sf::Color PlaceholderColor(64, 64, 70);  // Not loaded yet
+    constexpr unsigned StreamingSheetSlots = 4;  // Frames kept in VRAM
+    constexpr float VectorKnobSweep = 135.f;  // Degrees from top to ends
+    constexpr unsigned VectorCircleSegments = 64;  // Arcs are a part of it
+    constexpr std::size_t TextureCacheBudget = 128*1024*1024;  // Bytes
+    constexpr unsigned AtlasPageSize = 2048;  // Larger for larger images
+    constexpr unsigned AtlasPadding = 1;  // Pixels between packed images
+
+    class Gui;
+    struct MemoryReport;
+
+    template <typename... Ts>
+    class WidgetSet;
+
+    // Circle stretched by it's scale (knob collision shape for example)
+    struct Ellipse
+    {
+        sf::Vector2f center;
+        sf::Vector2f radii;  // Zero radii mean empty ellipse
+    };
 
     // Base/super class for all other widgets
     class AbstractWidget : public sf::Drawable, public sf::Transformable
     {
+        friend class Gui;
+
+        template <typename... Ts>
+        friend class WidgetSet;
+
+
+        public:
+            AbstractWidget();
+
+            // A copy does not belong to any ss::Gui or ss::WidgetSet
+            AbstractWidget(const AbstractWidget&);
+            AbstractWidget& operator=(const AbstractWidget&);
+
+            // Widget removes itself from it's ss::Gui
+            virtual ~AbstractWidget();
+
+
         public:
             virtual void handleEvent(const sf::Event&) = 0;
             virtual void update(const sf::Window&) = 0;
 
+            // True while widget holds the mouse (dragged knob for example).
+            // ss::Gui routes mouse events only to such widget until release
+            virtual bool grabsMouse() const;
+
+            // ss::Gui this widget was added to (nullptr if there is none)
+            Gui* gui() const;
+
+            // Animating widget is redrawn every frame by ss::Application
+            virtual bool animating() const;
+
+            // Active widget (hovered or hit) is updated first by ss::Gui
+            virtual bool active() const;
+
+            // Axis-aligned bounding box in window coordinates.
+            // ss::Gui sends mouse moves only to widgets under the cursor
+            // (and active ones). By default widget is everywhere
+            virtual sf::FloatRect bounds() const;
+
+            // Round widget is tested by ss::Gui against it's ellipse
+            // instead of bounds. By default widget is not round
+            virtual std::optional<Ellipse> ellipse() const;
+
+            // Adds bytes of the widget and of textures and fonts it uses.
+            // By default only ss::AbstractWidget itself is counted,
+            // custom widgets should override it
+            virtual void reportMemory(MemoryReport&) const;
+
 
         protected:
             virtual void draw(sf::RenderTarget&, sf::RenderStates) const = 0;
+
+            // Widget looks different now, it's ss::Gui should be redrawn
+            // (the one of it's ss::WidgetSet if it is in a set)
+            void invalidate();
+
+            // Widget bounds have changed, ss::Gui should know about it
+            void invalidateLayout();
+
+
+        private:
+            Gui* mGui;
+            AbstractWidget* mOwner;  // ss::WidgetSet widget is stored in
+            bool mUrgent;  // Queued for the first pass of ss::Gui::update
+            std::size_t mIndex;  // Position in ss::Gui
     };
 
     // Something that can be hovered/clicked. Button, Knob, Slider inherit it.
     template <typename T>
     class Clickable : public AbstractWidget
     {
+        template <typename... Ts>
+        friend class WidgetSet;  // Draws it without a virtual call
+
+
         private:
             using Callback = std::function<void(void)>;
 
@@ -103,12 +242,27 @@ namespace ss  // Interface goes here
             // Unfreezed object can change it's state (idle/hover/hit)
             void                unfreeze();
 
+            // Hover is computed from mouse events (MouseMoved, MouseLeft...)
             virtual void        handleEvent(const sf::Event&) override;
 
-            // Takes a reference to window because it will need to get
-            // relative mouse position
+            // Hover is tested again only if widget position or scale changed
+            // since the last update, idle frame does no hit tests
             virtual void        update(const sf::Window&) override;
 
+            // Clickable holds the mouse while it is hit
+            virtual bool        grabsMouse() const override;
+
+            // Clickable is active while it is hovered or hit
+            virtual bool        active() const override;
+
+            // Bounds of the collision shape
+            virtual sf::FloatRect bounds() const override;
+
+            // Ellipse of the collision shape if it is round
+            virtual std::optional<Ellipse> ellipse() const override;
+
+            virtual void        reportMemory(MemoryReport&) const override;
+
             // Observer methods
             const T&            collisionShape() const;
             State               state() const;
@@ -121,17 +275,32 @@ namespace ss  // Interface goes here
             virtual void        draw(sf::RenderTarget&,
                                     sf::RenderStates) const override;
 
+            // Precise test of a point that is in window coordinates.
+            // By default it is contains(collisionShape(), point)
+            virtual bool        hitTest(sf::Vector2i) const;
+
+            // Adds a widget of a derived type and it's callbacks
+            void                reportMemory(MemoryReport&,
+                                             const char* type,
+                                             std::size_t bytes) const;
+
 
         private:
             // Call a callback with respect to a current state
             void                call();
 
+            // Hover/idle transition for the last known cursor position
+            void                updateHover();
+
 
         private:
             T                   mCollisionShape;
             State               mState;
             Callback            mCallbacks[StateCount];
             bool                mFreezed;
+            sf::Vector2i        mCursor;  // Last cursor position from events
+            bool                mCursorInside;  // Cursor is in the window
+            bool                mLayoutDirty;  // Collision shape is outdated
     };
 
     // Center origin with respect to an object's local bounds
@@ -142,52 +311,477 @@ namespace ss  // Interface goes here
     template <typename A, typename B>
     float distance(A, B);
 
+    // True for events that carry mouse input (move, buttons, wheel...)
+    bool isMouseEvent(const sf::Event&);
+
+    // Texture has pixels (ss::ResourceLoader keeps it empty until then)
+    bool loaded(const sf::Texture*);
+
+    // Fast non-cryptographic hash of bytes (XXH64), keys of on-disk caches
+    std::uint64_t hash64(const void* data, std::size_t size,
+                         std::uint64_t seed=0);
+
+    // Frame of a vertical spritesheet of square frames for value in range
+    // [-1.0; 1.0]. Empty sheet rectangle means the whole texture
+    sf::IntRect spritesheetFrame(const sf::Texture&, sf::IntRect sheet,
+                                 float value);
+
     // Checks for collision of generic shape with a point (vector)
     template <typename T>
     bool contains(const T&, sf::Vector2i);
 
-    // Specialization for sf::CircleShape
+    // Specialization for sf::CircleShape (it's scale is taken into account)
     template <>
     bool contains<sf::CircleShape>(const sf::CircleShape&, sf::Vector2i);
 
-    // Clickable button that has a sprite for every state (idle/hover/hit)
-    class Button : public Clickable<sf::Sprite>
+    // Generic shape is not round
+    template <typename T>
+    std::optional<Ellipse> ellipse(const T&);
+
+    // Circle shape in global coordinates
+    template <>
+    std::optional<Ellipse> ellipse<sf::CircleShape>(const sf::CircleShape&);
+
+    // Squared distance test without sqrt, same math as ss::EllipseBatch
+    bool contains(const Ellipse&, sf::Vector2f);
+
+    // Edge equation: point is inside if a*x + b*y + c >= 0
+    struct HalfPlane
+    {
+        float a;
+        float b;
+        float c;
+    };
+
+    // Convex polygon to be used as a collision shape: Clickable<ConvexPolygon>
+    // Edge equations in global coordinates are computed on the first test
+    // and cached until the polygon is transformed (moved, scaled...)
+    class ConvexPolygon : public sf::Transformable
+    {
+        public:
+            // Points are in local coordinates in any (cw/ccw) order
+            ConvexPolygon(std::vector<sf::Vector2f> points={});
+
+
+        public:
+            const std::vector<sf::Vector2f>& points() const;
+
+            // The same interface as SFML shapes have
+            sf::FloatRect getLocalBounds() const;
+            sf::FloatRect getGlobalBounds() const;
+
+            // Point is in global coordinates, edges and vertices are inside
+            bool contains(sf::Vector2f) const;
+
+
+        private:
+            std::vector<sf::Vector2f> mPoints;
+            sf::FloatRect mLocalBounds;
+            mutable std::vector<HalfPlane> mEdges;
+            mutable sf::Transform mEdgesTransform;  // Edges are valid for it
+            mutable bool mEdgesValid;
+    };
+
+    // Collision shape made of several convex polygons and circles,
+    // contains a point if any of them does: Clickable<CompoundShape>
+    class CompoundShape : public sf::Transformable
+    {
+        public:
+            CompoundShape();
+
+
+        public:
+            // Polygon transform is applied to it's points once here
+            void add(const ConvexPolygon&);
+            void add(const sf::FloatRect&);
+
+            // Circle in local coordinates
+            void add(sf::Vector2f center, float radius);
+
+            // The same interface as SFML shapes have
+            sf::FloatRect getLocalBounds() const;
+            sf::FloatRect getGlobalBounds() const;
+
+            // Point is in global coordinates. Edges of polygons are inside
+            // them, circles are open as ss::Ellipse is
+            bool contains(sf::Vector2f) const;
+
+
+        private:
+            struct Circle
+            {
+                sf::Vector2f center;
+                float radius;
+            };
+
+
+        private:
+            std::vector<sf::Vector2f> mPoints;  // Of all polygons
+            std::vector<std::size_t> mPolygonSizes;  // Points per polygon
+            std::vector<Circle> mCircles;
+            sf::FloatRect mLocalBounds;
+            mutable std::vector<HalfPlane> mEdges;  // Of all polygons
+            mutable sf::Transform mEdgesTransform;  // Edges are valid for it
+            mutable bool mEdgesValid;
+    };
+
+    // Specialization for ss::ConvexPolygon
+    template <>
+    bool contains<ConvexPolygon>(const ConvexPolygon&, sf::Vector2i);
+
+    // Specialization for ss::CompoundShape
+    template <>
+    bool contains<CompoundShape>(const CompoundShape&, sf::Vector2i);
+
+    // Axis-aligned rectangle collision shape: a size and the position,
+    // scale and origin that ss::Clickable copies from the widget, nothing
+    // else (no texture, vertices or cached transforms as sprites have).
+    // Rotation is not supported. ss::Button uses it: Clickable<RectShape>
+    class RectShape
+    {
+        public:
+            explicit            RectShape(sf::Vector2f size=sf::Vector2f());
+
+
+        public:
+            // The same interface as SFML shapes have
+            const sf::Vector2f& getSize() const;
+            const sf::Vector2f& getPosition() const;
+            const sf::Vector2f& getScale() const;
+            const sf::Vector2f& getOrigin() const;
+            void                setPosition(sf::Vector2f);
+            void                setScale(sf::Vector2f);
+            void                setOrigin(float x, float y);
+            sf::FloatRect       getLocalBounds() const;
+            sf::FloatRect       getGlobalBounds() const;
+
+            // Point in global coordinates to local ones
+            sf::Vector2f        toLocal(sf::Vector2f) const;
+
+
+        private:
+            sf::Vector2f        mSize;
+            sf::Vector2f        mPosition;
+            sf::Vector2f        mScale;
+            sf::Vector2f        mOrigin;
+    };
+
+    // Opaque pixels of an image packed as bits (one bit per pixel).
+    // Used for pixel-accurate hit tests of irregularly shaped buttons
+    class HitMask
+    {
+        public:
+            // Pixel is opaque if it's alpha is not less than threshold
+            HitMask(const sf::Image&,
+                    std::uint8_t threshold=HitMaskAlphaThreshold);
+
+
+        public:
+            // Mask is built once per texture (it is slow: texture is
+            // copied to an image) and shared while somebody uses it.
+            // Texture should not be changed while it's mask is in use
+            // and the mask should be released with it's texture
+            static std::shared_ptr<const HitMask> of(const sf::Texture&);
+
+            // Pixel outside of the mask is transparent
+            bool                opaque(int x, int y) const;
+            sf::Vector2u        size() const;
+
+            // Heap memory of the bits
+            std::size_t         bytes() const;
+
+
+        private:
+            friend class Atlas;  // Masks of pages are saved to packs
+
+            HitMask(sf::Vector2u size, std::vector<std::uint64_t> bits);
+
+
+        private:
+            sf::Vector2u        mSize;
+            std::vector<std::uint64_t> mBits;
+    };
+
+    // Look of a button: texture and it's rectangle for every state.
+    // Skin is immutable, so buttons that look the same share one skin
+    // instead of keeping their own sprites.
+    // Skin with insets is a nine-slice one: corners of the rectangles keep
+    // their size, edges and center stretch, so one small texture region
+    // covers buttons of any size (see ss::Button and WidgetStore).
+    // Button smaller than the corners shrinks them in proportion
+    class ButtonSkin
+    {
+        public:
+            // Texture pixels from the sides of every state rectangle,
+            // Insets() is all zeros
+            struct Insets
+            {
+                unsigned        left;
+                unsigned        top;
+                unsigned        right;
+                unsigned        bottom;
+            };
+
+
+        public:
+            ButtonSkin(const sf::Texture&, sf::IntRect idle,
+                       sf::IntRect hover, sf::IntRect hit,
+                       Insets insets=Insets());
+
+            // Texture of ss::TextureCache, the skin holds it's handle
+            // so the cache never unloads the texture under the buttons
+            ButtonSkin(std::shared_ptr<const sf::Texture>, sf::IntRect idle,
+                       sf::IntRect hover, sf::IntRect hit,
+                       Insets insets=Insets());
+
+            // Sprites should have the same texture (or none)
+            ButtonSkin(const sf::Sprite& idle, const sf::Sprite& hover,
+                       const sf::Sprite& hit, Insets insets=Insets());
+
+
+        public:
+            const sf::Texture*  texture() const;
+            const sf::IntRect&  rect(State) const;
+            const Insets&       insets() const;
+
+            // Some of insets are not zero
+            bool                nineSlice() const;
+
+
+        private:
+            // Opposite insets fit in every state rectangle
+            bool                insetsFit() const;
+
+
+        private:
+            const sf::Texture*  mTexture;
+            std::shared_ptr<const sf::Texture> mHandle;  // If it is cached
+            sf::IntRect         mRects[StateCount];
+            Insets              mInsets;
+    };
+
+    // Look of knobs and sliders drawn from geometry instead of textures:
+    // a knob is a disc with a value arc and an indicator, a slider is
+    // a groove filled up to the value with a handle
+    struct VectorSkin
+    {
+        sf::Color       body = sf::Color(50, 50, 56);
+        sf::Color       track = sf::Color(30, 30, 34);  // Whole range
+        sf::Color       value = sf::Color(90, 160, 230);  // Up to value
+        sf::Color       indicator = sf::Color::White;  // Knob line, handle
+        float           thickness = 4.f;  // Of arcs, groove and indicator
+    };
+
+    // Vertical spritesheet of square frames preprocessed for drawing:
+    // every frame is trimmed to it's non-transparent bounds and identical
+    // frames are stored once. Frame table points to the compacted texture
+    class CompactSheet
     {
+        public:
+            struct Frame
+            {
+                sf::IntRect     rect;  // In the texture, empty if invisible
+                sf::Vector2i    offset;  // Of the rect in the whole frame
+            };
+
+
+        public:
+            explicit            CompactSheet(const sf::Image&);
+                                CompactSheet(const CompactSheet&) = delete;
+                                CompactSheet& operator=(
+                                    const CompactSheet&) = delete;
+
+
+        public:
+            // Frame for value in range [-1.0; 1.0]
+            const Frame&        frame(float value) const;
+
+            const sf::Texture&  texture() const;
+
+            unsigned            frameSize() const;  // Of the whole frame
+            unsigned            frameCount() const;
+            unsigned            uniqueCount() const;  // Frames in texture
+
+
+        private:
+            std::vector<Frame>  mFrames;
+            unsigned            mSize;
+            unsigned            mUniqueCount;
+            sf::Texture         mTexture;
+    };
+
+    // Vertical spritesheet of square frames that stays in system memory.
+    // Only a few frames are in it's texture, a frame is uploaded to the
+    // least recently used slot when it is drawn. Knobs and sliders get
+    // their frames right before drawing, so they can share a sheet even
+    // if they show more frames than there are slots
+    class StreamingSheet
+    {
+        public:
+            explicit            StreamingSheet(
+                                    const sf::Image&,
+                                    unsigned slots=StreamingSheetSlots);
+                                StreamingSheet(const StreamingSheet&)
+                                    = delete;
+                                StreamingSheet& operator=(
+                                    const StreamingSheet&) = delete;
+
+
+        public:
+            // Rectangle of the frame for value in range [-1.0; 1.0]
+            // in the texture, it is uploaded if it is not there
+            sf::IntRect         frame(float value);
+
+            // Small texture of slots (empty if the image is)
+            const sf::Texture&  texture() const;
+
+            unsigned            frameSize() const;
+            unsigned            frameCount() const;
+
+            // Frames uploaded since construction
+            std::size_t         uploads() const;
+
+            // System memory of the image
+            std::size_t         bytes() const;
+
+
+        private:
+            std::vector<std::uint8_t> mPixels;  // Whole image
+            unsigned            mSize;  // Width and height of a frame
+            unsigned            mFrames;
+            sf::Texture         mTexture;
+            std::vector<unsigned> mSlotFrames;  // Frame in slot or mFrames
+            std::vector<std::uint64_t> mSlotUses;  // For LRU
+            std::uint64_t       mUses;
+            std::size_t         mUploads;
+    };
+
+    // Clickable button that has a texture rectangle for every state
+    // (idle/hover/hit) in it's shared skin
+    class Button : public Clickable<RectShape>
+    {
+        template <typename... Ts>
+        friend class WidgetSet;  // Draws it without a virtual call
+
+
         public:
             // Default values are dummies
             // Button should be constructed properly for adequate use
-            // Button collision shape is a shape of sprite for idle state
+            // Button collision shape is a rectangle of the size of idle
+            // state rectangle of the skin, placed by the button transform.
+            // Skin is made of the sprites, only their textures and
+            // texture rectangles are used
             Button(sf::Sprite idle=sf::Sprite(),
                    sf::Sprite hover=sf::Sprite(),
                    sf::Sprite hit=sf::Sprite());
 
+            Button(std::shared_ptr<const ButtonSkin>);
+
+            // Button of any size drawn by a nine-slice skin (nine quads
+            // in one draw call), collision shape is a rectangle of the size
+            Button(std::shared_ptr<const ButtonSkin>, sf::Vector2f size);
+
 
         public:
-            virtual void update(const sf::Window&) override;
+            // Sprite of a state rectangle of the skin (made on request).
+            // It is what draw renders for plain skins only: a nine-slice
+            // button stretches the rectangle to it's size, the sprite
+            // is the unstretched rectangle
+            sf::Sprite sprite(State) const;
+
+            const std::shared_ptr<const ButtonSkin>& skin() const;
 
-            const sf::Sprite& sprite(State) const;
+            // Mask of idle sprite texture. Transparent pixels of the idle
+            // sprite are not hovered/clicked then (nullptr disables it).
+            // Nine-slice buttons are hit by the whole rectangle
+            void setHitMask(std::shared_ptr<const HitMask>);
+
+            // Skin and hit mask are counted once for all buttons sharing them
+            virtual void reportMemory(MemoryReport&) const override;
 
 
         protected:
             virtual void draw(
                 sf::RenderTarget&, sf::RenderStates) const override;
 
+            // Bounding box test first, then a single bit of hit mask
+            virtual bool hitTest(sf::Vector2i) const override;
+
 
         private:
-            sf::Sprite mSprites[StateCount];
+            std::shared_ptr<const ButtonSkin> mSkin;
+            std::shared_ptr<const HitMask> mHitMask;
     };
 
+    namespace detail  // Widget internals, not a part of the interface
+    {
+        // Spritesheet skin of a knob or slider
+        struct TextureSheet
+        {
+            const sf::Texture*  texture;
+            sf::IntRect         sheet;  // Empty for the whole texture
+            std::shared_ptr<const sf::Texture> handle;  // If it is cached
+        };
+
+        // Static part of a vector skin (sf::TriangleStrip) for one widget
+        // size, shared by all widgets that look the same
+        struct VectorBody
+        {
+            VectorSkin          skin;
+            sf::VertexArray     vertices;
+        };
+
+        // Vector skin of a widget: shared body and it's own value part
+        struct VectorGeometry
+        {
+            std::shared_ptr<const VectorBody> body;
+            sf::VertexArray     value;  // sf::TriangleStrip
+            float               valueBuilt;  // Value has been built for it
+        };
+
+        // Skin of a knob or slider, only one of them is kept
+        using WidgetSkin = std::variant<TextureSheet,
+                                        std::shared_ptr<StreamingSheet>,
+                                        std::shared_ptr<const CompactSheet>,
+                                        VectorGeometry>;
+    }  // namespace detail
+
     // Dragable/scrollable knob that does use
     // of sf::CircleShape as a collisionShape.
     // It's spritesheet must be (vertical) of size 1 (width) x N (height) 
     // Single sprite in that spritesheet must be a square (N x N pixels)
     class Knob : public Clickable<sf::CircleShape>
     {
+        template <typename... Ts>
+        friend class WidgetSet;  // Draws it without a virtual call
+
+
         public:
             // Should be constructed property to work well
-            // Default parameter values are dummies
+            // Default parameter values are dummies.
+            // Texture rectangle of the sprite is the spritesheet (an atlas
+            // region for example), sprite of a whole texture is fine too
             Knob(sf::CircleShape collisionShape=sf::CircleShape(),
                  sf::Sprite sprite=sf::Sprite());
+
+            // Spritesheet of ss::TextureCache (whole texture if the sheet
+            // is empty), the knob holds the handle so the cache keeps it
+            Knob(sf::CircleShape collisionShape,
+                 std::shared_ptr<const sf::Texture>,
+                 sf::IntRect sheet=sf::IntRect());
+
+            // Frames are streamed from the sheet when they are drawn
+            Knob(sf::CircleShape collisionShape,
+                 std::shared_ptr<StreamingSheet>);
+
+            // Trimmed frames are drawn where they are in the whole frame
+            Knob(sf::CircleShape collisionShape,
+                 std::shared_ptr<const CompactSheet>);
+
+            // No texture at all. Geometry of the body is shared by knobs
+            // of the same skin and radius, geometry of the value is
+            // rebuilt when the value changes
+            Knob(sf::CircleShape collisionShape, const VectorSkin&);
  
 
         public:
@@ -199,6 +793,8 @@ namespace ss  // Interface goes here
 
             void setValue(float);
 
+            virtual void reportMemory(MemoryReport&) const override;
+
 
         protected:
             virtual void draw(
@@ -206,43 +802,66 @@ namespace ss  // Interface goes here
 
 
         private:
-            // Calculates a sprite texture rectangle with respect to mValue
-            sf::IntRect textureRect();
-
-
-        private:
-            sf::Sprite mSprite;
+            detail::WidgetSkin mSkin;  // Frame is placed when it is drawn
             float mValue;  // Like a knob angle but in range [-1.0; 1.0]
-            float mPreviousMouseY;  // Used in update method
+            float mPreviousMouseY;  // Cursor y of the previous drag event
     };
 
     // Dragable slider that can be either vertical or horizontal
     // May be used as a progress bar also: freeze it and setValue
     class Slider : public Clickable<sf::RectangleShape>
     {
+        template <typename... Ts>
+        friend class WidgetSet;  // Draws it without a virtual call
+
+
         public:
             Slider();
+            // Sprite is a spritesheet as ss::Knob has
             Slider(sf::RectangleShape collisionShape,
                 sf::Sprite sprite,
                 SliderType type);
+            // Spritesheet of ss::TextureCache held by it's handle
+            Slider(sf::RectangleShape collisionShape,
+                std::shared_ptr<const sf::Texture>,
+                SliderType type,
+                sf::IntRect sheet=sf::IntRect());
+            Slider(sf::RectangleShape collisionShape,
+                std::shared_ptr<StreamingSheet>,
+                SliderType type);
+            Slider(sf::RectangleShape collisionShape,
+                std::shared_ptr<const CompactSheet>,
+                SliderType type);
+            Slider(sf::RectangleShape collisionShape,
+                const VectorSkin&,
+                SliderType type);
 
 
         public:
+            // Slider tracks the cursor from mouse events while it is hit
+            virtual void handleEvent(const sf::Event&) override;
             virtual void update(const sf::Window&) override;
 
             float value() const;
             void setValue(float);
 
+            virtual void reportMemory(MemoryReport&) const override;
+
 
         protected:
             virtual void draw(
                 sf::RenderTarget&, sf::RenderStates) const override;
 
 
+        private:
+            // Sets value with respect to the cursor position
+            void track(sf::Vector2i);
+
+
         private:
             bool mInitialized;  // Constructed with default constructor?
             float mValue;  // Slider progress
-            sf::Sprite mSprite;
+            detail::WidgetSkin mSkin;  // Frame is placed when it is drawn
             SliderType mType;  // Vertical/Horizontal
     };
 
@@ -250,6 +869,10 @@ namespace ss  // Interface goes here
     // Backspace erases last character if there is one
     class LineEdit : public Clickable<sf::RectangleShape>
     {
+        template <typename... Ts>
+        friend class WidgetSet;  // Draws it without a virtual call
+
+
         public:
             LineEdit();
             LineEdit(sf::RectangleShape collisionShape, sf::Text text);
@@ -262,6 +885,9 @@ namespace ss  // Interface goes here
             void                setString(const sf::String&);
             const sf::String&   string() const;
 
+            // Text vertices are estimated, glyph page of the font is counted
+            virtual void        reportMemory(MemoryReport&) const override;
+
 
         protected:
             virtual void draw(
@@ -272,389 +898,5867 @@ namespace ss  // Interface goes here
             bool mInitialized;  // Constructed with default constructor?
             sf::Text mText;
     };
-}
 
-/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+    // Structure-of-arrays storage of axis-aligned rectangles.
+    // A point is tested against SimdWidth rectangles at once
+    // (one AVX instruction or two SSE ones per comparison).
+    class RectBatch
+    {
+        public:
+            // Bit i is set if rectangle i contains the point
+            using Mask = std::vector<std::uint64_t>;
 
-#ifdef SSGUI_IMPL  // Implementation starts here
 
-namespace ss
-{
-    template <typename T>
-    Clickable<T>::Clickable(T collisionShape)
-    : mCollisionShape(std::move(collisionShape))
-    , mState(Idle)
-    , mCallbacks{[](){}, [](){}, [](){}}
-    , mFreezed(false)
-    {
-    }
+        public:
+                                RectBatch();
 
-    template <typename T>
-    void Clickable<T>::bind(State state, Callback callback)
-    {
-        mCallbacks[static_cast<unsigned>(state)] = std::move(callback);
-    }
 
-    template <typename T>
-    void Clickable<T>::freeze(State state)
-    {
-        mState = state;
-        mFreezed = true;
-    }
+        public:
+            void                push(const sf::FloatRect&);
+            void                set(std::size_t, const sf::FloatRect&);
+            void                erase(std::size_t);
+            void                clear();
+            std::size_t         size() const;
 
-    template <typename T>
-    void Clickable<T>::unfreeze()
-    {
-        mFreezed = false;
-    }
+            // Same semantics as sf::FloatRect::contains.
+            // In debug build the result is checked against hitMaskScalar
+            void                hitMask(sf::Vector2f, Mask&) const;
+            void                hitMaskScalar(sf::Vector2f, Mask&) const;
 
-    template <typename T>
-    void Clickable<T>::handleEvent(const sf::Event& event)
-    {
-        if (mFreezed)
-            return;
+            // Heap memory of the arrays
+            std::size_t         bytes() const;
 
-        if (event.type == sf::Event::MouseButtonPressed)
-        {
-            if (mState == Hover 
-                and event.mouseButton.button == sf::Mouse::Left)
-            {
-                mState = Hit;
-                call();
-            }
-        }
-        else if (event.type == sf::Event::MouseButtonReleased)
-        {
-            if (mState == Hit
-                and event.mouseButton.button == sf::Mouse::Left)
-            {
-                mState = Hover;
-                call();
-            }
-        }
-    }
 
+        private:
+            // Arrays are padded with empty rectangles to SimdWidth
+            void                pad();
+
+
+        private:
+            std::vector<float>  mLeft;
+            std::vector<float>  mTop;
+            std::vector<float>  mRight;
+            std::vector<float>  mBottom;
+            std::size_t         mSize;
+    };
+
+    // Structure-of-arrays storage of ellipses (centers and inverse radii),
+    // ss::RectBatch for round widgets like knobs.
+    // A point is tested against SimdWidth ellipses at once without sqrt.
+    class EllipseBatch
+    {
+        public:
+            // Bit i is set if ellipse i contains the point
+            using Mask = RectBatch::Mask;
+
+
+        public:
+                                EllipseBatch();
+
+
+        public:
+            void                push(const Ellipse&);
+            void                set(std::size_t, const Ellipse&);
+            void                erase(std::size_t);
+            void                clear();
+            std::size_t         size() const;
+
+            // Same semantics as ss::contains(const Ellipse&, sf::Vector2f).
+            // In debug build the result is checked against hitMaskScalar
+            void                hitMask(sf::Vector2f, Mask&) const;
+            void                hitMaskScalar(sf::Vector2f, Mask&) const;
+
+            // Heap memory of the arrays
+            std::size_t         bytes() const;
+
+
+        private:
+            // Arrays are padded with empty ellipses to SimdWidth
+            void                pad();
+
+
+        private:
+            std::vector<float>  mCenterX;
+            std::vector<float>  mCenterY;
+            std::vector<float>  mInverseRadiusX;
+            std::vector<float>  mInverseRadiusY;
+            std::size_t         mSize;
+    };
+
+    // Bump allocator for scratch data that lives until the end of a frame.
+    // Allocation is a pointer increment, nothing is freed until reset().
+    // Blocks are kept after reset, so once a few frames have grown
+    // the arena, a frame like them allocates nothing for data in it.
+    // Only what is put to it is there: ss::Application keeps tasks and
+    // timers of a frame in it, while gui, widgets and hit test batches
+    // reuse their own member buffers instead
+    class FrameArena
+    {
+        public:
+                                FrameArena(
+                                    std::size_t blockSize=FrameArenaBlockSize);
+                                FrameArena(const FrameArena&) = delete;
+                                FrameArena& operator=(const FrameArena&)
+                                    = delete;
+
+
+        public:
+            // Request bigger than a block gets a block of it's own
+            void*               allocate(std::size_t size,
+                                         std::size_t alignment);
+
+            // Everything allocated since the previous reset is freed
+            void                reset();
+
+            // Bytes allocated since the previous reset
+            std::size_t         used() const;
+
+            // Bytes in all blocks
+            std::size_t         capacity() const;
+
+
+        private:
+            struct Block
+            {
+                std::unique_ptr<std::byte[]> data;
+                std::size_t     size;
+            };
+
+
+        private:
+            std::vector<Block>  mBlocks;
+            std::size_t         mBlockSize;
+            std::size_t         mCurrent;  // Block being filled
+            std::size_t         mOffset;  // In the current block
+            std::size_t         mUsed;
+    };
+
+    // Standard allocator interface for ss::FrameArena, so standard
+    // containers can keep their scratch data in it: ss::FrameVector<T>
+    template <typename T>
+    class FrameAllocator
+    {
+        public:
+            using value_type = T;
+
+
+        public:
+                                FrameAllocator(FrameArena&);
+
+                                template <typename U>
+                                FrameAllocator(const FrameAllocator<U>&);
+
+
+        public:
+            T*                  allocate(std::size_t n);
+
+            // Memory is freed all at once by FrameArena::reset
+            void                deallocate(T*, std::size_t);
+
+            FrameArena&         arena() const;
+
+
+        private:
+            FrameArena*         mArena;
+    };
+
+    template <typename T, typename U>
+    bool operator==(const FrameAllocator<T>&, const FrameAllocator<U>&);
+
+    template <typename T, typename U>
+    bool operator!=(const FrameAllocator<T>&, const FrameAllocator<U>&);
+
+    // Vector that should not outlive the frame it was created in
     template <typename T>
-    void Clickable<T>::update(const sf::Window& window)
+    using FrameVector = std::vector<T, FrameAllocator<T>>;
+
+    // Memory used by widgets (see ss::Gui::memoryReport).
+    // Textures, glyph pages and shared objects (skins, hit masks)
+    // are counted once however many widgets use them
+    struct MemoryReport
+    {
+        struct Usage
+        {
+            std::size_t count;
+            std::size_t bytes;  // Of all widgets of the type
+        };
+
+        std::map<std::string, Usage> widgets;  // By type ("ss::Button"...)
+        std::map<const sf::Texture*, std::size_t> textures;  // 4 bytes/pixel
+        std::map<std::pair<const sf::Font*, unsigned>, std::size_t> glyphs;
+        std::map<const void*, std::size_t> shared;
+
+        // Part of widget bytes taken by std::function objects (captures
+        // that don't fit into std::function itself are not visible)
+        std::size_t callbackBytes = 0;
+
+        void                addWidget(const std::string& type,
+                                      std::size_t bytes);
+        void                addTexture(const sf::Texture*);
+        void                addGlyphs(const sf::Font*,
+                                      unsigned characterSize);
+        void                addShared(const void*, std::size_t bytes);
+
+        std::size_t         widgetBytes() const;
+        std::size_t         textureBytes() const;
+        std::size_t         glyphBytes() const;
+        std::size_t         sharedBytes() const;
+        std::size_t         totalBytes() const;
+    };
+
+    // Limits in bytes for ss::Gui::setMemoryBudget, zero means no limit
+    struct MemoryBudget
+    {
+        std::size_t widgets = 0;
+        std::size_t textures = 0;
+        std::size_t glyphs = 0;
+        std::size_t total = 0;
+    };
+
+    // Dispatches events, updates and draws a set of widgets.
+    // Gui does not own widgets, it only keeps pointers to them.
+    // Pointer capture: when a widget gets hit (knob or slider is dragged,
+    // button is pressed) all mouse events go to that widget only
+    // and other widgets are not hover tested until the mouse is released.
+    class Gui : public sf::Drawable
+    {
+        friend class AbstractWidget;
+
+
+        public:
+                                Gui();
+                                Gui(const Gui&) = delete;
+                                Gui& operator=(const Gui&) = delete;
+                                ~Gui();
+
+
+        public:
+            // Widgets are drawn in order they were added (last is on top)
+            void                add(AbstractWidget&);
+            void                remove(AbstractWidget&);
+
+            void                handleEvent(const sf::Event&);
+
+            // Without a budget every widget is updated.
+            // With a budget active (hovered, hit) and invalidated widgets
+            // are updated first, then other widgets are updated round-robin
+            // until the budget is spent, so they may lag a frame or two
+            void                update(const sf::Window&);
+
+            // Time limit for one update call (zero means no limit)
+            void                setUpdateBudget(sf::Time);
+
+            // Widget that holds the mouse now (nullptr if there is none)
+            AbstractWidget*     captured() const;
+
+            // Cursor as the widget should see it. Nothing if the cursor
+            // is out of the window or is captured by another widget
+            std::optional<sf::Vector2i> cursorFor(const AbstractWidget&) const;
+
+            // Gui is dirty when some widget has changed since last drawing.
+            // validate() should be called after the gui has been drawn
+            bool                dirty() const;
+            void                invalidate();
+            void                validate();
+
+            // Some widget is animating
+            bool                animating() const;
+
+            // Scratch memory of the current frame for ss::FrameVector.
+            // Gui itself keeps nothing in it. ss::Application resets it at
+            // the end of every frame, a custom main loop that uses it
+            // should do it itself
+            FrameArena&         frameArena();
+
+            // Memory of all widgets and of the gui itself
+            MemoryReport        memoryReport() const;
+
+            // Report is checked against the budget by the first update
+            // after widgets are added or removed or textures are loaded,
+            // every exceeded limit is written to sf::err()
+            void                setMemoryBudget(const MemoryBudget&);
+
+            // Textures of widgets have changed (a resource loader has
+            // finished one), the budget is checked by the next update.
+            // ss::Application calls it, a custom main loop should call it
+            // when ss::ResourceLoader::upload returns true
+            void                invalidateMemory();
+
+
+        protected:
+            virtual void        draw(sf::RenderTarget&,
+                                    sf::RenderStates) const override;
+
+
+        private:
+            // Widget has changed: gui is dirty and widget is queued
+            void                invalidate(AbstractWidget&);
+
+            // Widget will be updated in the first pass of budgeted update,
+            // gui is not made dirty by it
+            void                enqueue(AbstractWidget&);
+
+            void                invalidateLayout(AbstractWidget&);
+
+            // Sends MouseMoved to widgets under the cursor
+            // and to hovered ones (they should see the cursor leaving)
+            void                moveCursor(const sf::Event&);
+            bool                hit(std::size_t index) const;
+
+            // Active widget will get mouse moves even if cursor leaves it
+            void                hover(AbstractWidget&);
+
+            void                capture(AbstractWidget*);
+
+            // Widgets get MouseMoved for the last cursor position
+            // to find out their hover state after the capture
+            void                release();
+
+            void                checkMemoryBudget();
+
+
+        private:
+            std::vector<AbstractWidget*> mWidgets;
+            AbstractWidget*     mCaptured;
+            sf::Vector2i        mCursor;  // Last cursor position from events
+            bool                mCursorInside;  // Cursor is in the window
+            bool                mDirty;
+            sf::Time            mUpdateBudget;
+            std::vector<AbstractWidget*> mUrgent;  // For the first pass
+            std::vector<AbstractWidget*> mUpdating;  // First pass in progress
+            std::size_t         mNext;  // Next widget of round-robin pass
+            RectBatch           mBounds;  // Bounds of every not round widget
+            EllipseBatch        mEllipses;  // Ellipses of round widgets
+            RectBatch::Mask     mHits;  // Widgets under the cursor
+            RectBatch::Mask     mEllipseHits;
+            std::vector<AbstractWidget*> mHovered;  // Active widgets
+            std::vector<AbstractWidget*> mWasHovered;  // Used by moveCursor
+            FrameArena          mFrameArena;
+            MemoryBudget        mMemoryBudget;
+            bool                mMemoryChecked;  // Since widgets changed
+    };
+
+    // Debug text with the memory report of a gui: bytes per widget type,
+    // texture of every skin, glyph pages and the total.
+    // It is refreshed a few times a second, add it to the gui to see it
+    class MemoryOverlay : public AbstractWidget
+    {
+        public:
+                                MemoryOverlay(const Gui&, const sf::Font&,
+                                              unsigned characterSize=14);
+
+
+        public:
+            virtual void        handleEvent(const sf::Event&) override;
+            virtual void        update(const sf::Window&) override;
+
+            // Overlay is never hovered or clicked
+            virtual sf::FloatRect bounds() const override;
+
+            virtual void        reportMemory(MemoryReport&) const override;
+
+
+        protected:
+            virtual void        draw(sf::RenderTarget&,
+                                    sf::RenderStates) const override;
+
+
+        private:
+            const Gui&          mGui;
+            sf::Text            mText;
+            sf::Clock           mClock;  // Since the last refresh
+            bool                mRefreshed;  // At least once
+    };
+
+    // Loads textures and fonts without blocking the main loop.
+    // Files are read and decoded by worker threads. Decoded images are
+    // uploaded by upload() on the render thread, a bounded number of bytes
+    // per call, to a staging texture that is swapped with the target one
+    // when it is complete. Until then the texture is empty and widgets
+    // draw placeholders. ss::Application calls upload() every frame.
+    // Textures and fonts should outlive the loader
+    class ResourceLoader
+    {
+        private:
+            using Callback = std::function<void(void)>;
+
+
+        public:
+                                ResourceLoader(
+                                    unsigned threads=ResourceLoaderThreads);
+                                ResourceLoader(const ResourceLoader&)
+                                    = delete;
+                                ResourceLoader& operator=(
+                                    const ResourceLoader&) = delete;
+
+                                // Waits for the files being decoded now,
+                                // others are not loaded
+                                ~ResourceLoader();
+
+
+        public:
+            // Callback is called by upload() when the resource is ready
+            // or when it has failed. A file that can't be loaded is
+            // reported to sf::err() by SFML and it's resource stays empty
+            // (see ss::loaded)
+            void                load(sf::Texture&, const std::string& path,
+                                     Callback=nullptr);
+            void                load(sf::Font&, const std::string& path,
+                                     Callback=nullptr);
+
+            // Files embedded to the binary (see ssembed.cpp) are decoded
+            // with loadFromMemory. Data should outlive the loader and
+            // font data should outlive the font too
+            void                load(sf::Texture&, const void* data,
+                                     std::size_t size, Callback=nullptr);
+            void                load(sf::Font&, const void* data,
+                                     std::size_t size, Callback=nullptr);
+
+            // Uploads decoded images (at least a row of pixels per call).
+            // True if some resource is ready now, gui should be redrawn
+            bool                upload(
+                                    std::size_t maxBytes
+                                        =ResourceLoaderUploadBytes);
+
+            // Resources that are not ready yet
+            std::size_t         pending() const;
+
+
+        private:
+            struct Job
+            {
+                sf::Texture*    texture;  // Either texture
+                sf::Font*       font;  // or font is loaded
+                std::string     path;
+                const void*     data;  // Instead of path if it is not null
+                std::size_t     size;
+                Callback        callback;
+                sf::Image       image;  // Decoded by a worker
+                sf::Font        loadedFont;
+                bool            failed;
+            };
+
+
+        private:
+            void                enqueue(std::unique_ptr<Job>);
+
+            // Worker thread decodes files until the loader is destroyed
+            void                work();
+
+            void                finish();
+
+
+        private:
+            std::vector<std::thread> mWorkers;
+            std::mutex          mMutex;  // Guards queues and mStopping
+            std::condition_variable mCondition;
+            std::deque<std::unique_ptr<Job>> mQueue;  // Not decoded yet
+            std::deque<std::unique_ptr<Job>> mDecoded;
+            bool                mStopping;
+
+            // Render thread only
+            std::unique_ptr<Job> mUploading;
+            sf::Texture         mStaging;
+            unsigned            mRow;  // First row not uploaded yet
+            std::size_t         mPending;
+    };
+
+    // Textures by path: a file is loaded once and shared by handles.
+    // Textures without handles stay loaded while they fit the memory
+    // budget, the least recently used of them are unloaded when they
+    // don't. Texture object itself is never destroyed, so get() reloads
+    // an unloaded texture in place.
+    // Widgets must hold handles of the textures they draw: ss::ButtonSkin,
+    // ss::Knob and ss::Slider take them. A raw pointer (sf::Sprite made
+    // of *handle) does not count, trim() may unload the texture under it
+    // and the widget falls back to a placeholder until the next get()
+    class TextureCache
+    {
+        public:
+            using Handle = std::shared_ptr<const sf::Texture>;
+
+
+        public:
+            explicit            TextureCache(
+                                    std::size_t budget=TextureCacheBudget);
+                                TextureCache(const TextureCache&) = delete;
+                                TextureCache& operator=(
+                                    const TextureCache&) = delete;
+
+
+        public:
+            // Texture of the file, it is loaded if it is not. With a
+            // resource loader it is loaded in background (and it is empty
+            // until then), otherwise right now
+            Handle              get(const std::string& path);
+
+            // Loaded textures are trimmed to fit a new budget
+            void                setBudget(std::size_t bytes);
+
+            // Loader should not outlive the cache (nullptr to load in place)
+            void                setResourceLoader(ResourceLoader*);
+
+            // Unloads least recently used textures without handles
+            // until loaded textures fit the budget
+            void                trim();
+
+            // Memory of loaded textures
+            std::size_t         bytes() const;
+
+            std::size_t         loadedCount() const;
+
+            // Loaded textures, used by widgets or not
+            void                reportMemory(MemoryReport&) const;
+
+
+        private:
+            struct Entry
+            {
+                std::shared_ptr<sf::Texture> texture;  // Handles share it
+                std::uint64_t   lastUse;  // mUses when get() was called
+                std::size_t     bytes;  // Zero if it is not loaded
+                bool            loading;  // By the resource loader
+            };
+
+
+        private:
+            // Counts memory of the texture that has been loaded
+            void                account(Entry&);
+
+
+        private:
+            std::map<std::string, Entry> mEntries;
+            std::uint64_t       mUses;
+            std::size_t         mBytes;
+            std::size_t         mBudget;
+            ResourceLoader*     mLoader;
+    };
+
+    // Startup asset pipeline for many skins. Files registered by add() are
+    // decoded by build() on all cores, packed to a few atlas pages and each
+    // page is uploaded once. Sprites refer to the pages, so the atlas should
+    // outlive them. Building again replaces pages of the previous build.
+    //
+    // savePack() does the cpu part offline (see sspack.cpp) and writes
+    // pages as raw RGBA, so loadPack() only maps the file and uploads it.
+    // With a cache directory build() saves such a pack there keyed by a
+    // hash of names and file contents, the next build with the same files
+    // loads it instead of decoding and packing. Changed files change the
+    // key, stale packs are just not used anymore.
+    // Pack layout, all numbers are little-endian:
+    //      header  "SSPK", u32 version, u32 page count, u32 entry count
+    //      page    u32 width, u32 height, u64 offset of RGBA pixels,
+    //              u64 offset of hit mask bits (u64 words, row by row)
+    //      entry   u32 page, i32 left, top, width, height, u32 frames,
+    //              u32 name size, name padded to 4 bytes
+    //      data    pixels and mask of every page, 4 bytes aligned
+    class Atlas
+    {
+        public:
+            // How long each stage of the last build or pack load took
+            struct Timings
+            {
+                sf::Time        decode;  // Reading, hashing and decoding
+                                         // or mapping of the pack
+                sf::Time        pack;  // Composition of pages and masks
+                sf::Time        upload;
+            };
+
+
+        public:
+                                Atlas();
+                                Atlas(const Atlas&) = delete;
+                                Atlas& operator=(const Atlas&) = delete;
+
+
+        public:
+            // Image file is found by it's name after build
+            void                add(const std::string& name,
+                                    const std::string& path);
+
+            // Directory for packs of builds (empty disables the cache),
+            // it should exist
+            void                setCacheDirectory(const std::string&);
+
+            // False if some file can't be loaded or doesn't fit a page,
+            // it is reported to sf::err() and other skins are usable
+            bool                build(unsigned threads
+                                        =std::thread::hardware_concurrency());
+
+            // Builds pages and writes the pack without uploading it,
+            // sprites are empty until the next build or load
+            bool                savePack(const std::string& path,
+                                         unsigned threads
+                                        =std::thread::hardware_concurrency());
+
+            // Replaces pages and skins with the pack ones. Pixels are
+            // uploaded straight from the mapped file, nothing is decoded
+            bool                loadPack(const std::string& path);
+
+            // Texture rectangle of the image is the whole skin (spritesheet
+            // of a knob or slider, all states of a button...)
+            sf::Sprite          sprite(const std::string& name) const;
+            bool                contains(const std::string& name) const;
+
+            // Square frames of a vertical spritesheet (knob or slider skin)
+            unsigned            frames(const std::string& name) const;
+
+            // Mask of the whole page of the skin (for Button::setHitMask)
+            std::shared_ptr<const HitMask> hitMask(
+                                    const std::string& name) const;
+
+            std::size_t         pageCount() const;
+            const sf::Texture&  page(std::size_t) const;
+
+            const Timings&      timings() const;
+
+
+        private:
+            struct Entry
+            {
+                std::string     name;
+                std::string     path;  // Empty if it is from a pack
+                std::size_t     page;
+                sf::IntRect     rect;  // Empty if it is not built
+            };
+
+
+        private:
+            // Reads files, the key is a hash of names and contents
+            std::uint64_t       read(unsigned threads,
+                                     std::vector<std::vector<char>>& files);
+
+            // Decodes, packs and composes pages and masks on the cpu
+            bool                prepare(unsigned threads,
+                                        std::vector<std::vector<char>>& files,
+                                        std::vector<sf::Image>& pages);
+
+            // Places images to pages, true if all of them fit
+            bool                pack(const std::vector<sf::Image>&,
+                                     std::vector<sf::Vector2u>& pageSizes);
+
+            void                upload(const std::vector<sf::Image>& pages);
+
+            bool                writePack(const std::string& path,
+                                          const std::vector<sf::Image>&);
+
+            // Silent, so a missing cache file is not an error
+            bool                readPack(const std::string& path);
+
+
+        private:
+            std::vector<Entry>  mEntries;
+            std::map<std::string, std::size_t> mNames;  // Entry indices
+            std::vector<std::unique_ptr<sf::Texture>> mPages;  // Stable
+            std::vector<std::shared_ptr<const HitMask>> mMasks;  // Per page
+            std::string         mCacheDirectory;
+            Timings             mTimings;
+    };
+
+    // Main loop for a window with a gui.
+    // Gui is drawn only when it is dirty or animating.
+    // When there are no events, tasks, timers and animations the loop sleeps,
+    // so an idle application does not load the cpu.
+    class Application
+    {
+        private:
+            using Task = std::function<void(void)>;
+            using EventHandler = std::function<void(const sf::Event&)>;
+
+
+        public:
+                                Application(sf::RenderWindow&, Gui&);
+
+
+        public:
+            // Returns when the window is closed
+            void                run();
+
+            // Task will be called by the loop (thread-safe, wakes the loop)
+            void                post(Task);
+
+            // Task will be called by the loop once after a delay
+            void                schedule(sf::Time, Task);
+
+            // Handler gets every event before the gui does
+            void                setEventHandler(EventHandler);
+
+            void                setClearColor(sf::Color);
+
+            // Loader uploads resources every frame (nullptr disables it)
+            void                setResourceLoader(ResourceLoader*);
+
+            // Gui is updated at a fixed rate independent of rendering.
+            // Events are still handled as soon as they come, so input
+            // latency does not depend on drawing time.
+            // 0 (default) means one update per loop iteration
+            void                setTickRate(unsigned ticksPerSecond);
+
+            // Part of the tick elapsed since the last update [0.0; 1.0).
+            // Animating widgets may use it to interpolate between ticks
+            float               interpolation() const;
+
+
+        private:
+            // Each returns true if it has done something
+            bool                processEvents();
+            bool                runTasks();
+            bool                runTimers();
+            bool                uploadResources();
+
+            // Updates gui for every tick elapsed since the previous call
+            void                tick();
+
+            void                render();
+
+            // Sleeps until the next poll, the nearest timer or a post
+            void                sleep();
+
+
+        private:
+            struct Timer
+            {
+                sf::Time        deadline;
+                Task            task;
+            };
+
+
+        private:
+            sf::RenderWindow&   mWindow;
+            Gui&                mGui;
+            EventHandler        mEventHandler;
+            sf::Color           mClearColor;
+            sf::Clock           mClock;
+            sf::Clock           mTickClock;
+            sf::Time            mTick;  // Zero if tick rate is not fixed
+            sf::Time            mLag;  // Time not simulated by ticks yet
+            std::vector<Timer>  mTimers;
+            std::vector<Task>   mTasks;
+            std::mutex          mTasksMutex;
+            std::condition_variable mTaskPosted;  // Wakes sleep()
+            ResourceLoader*     mLoader;
+    };
+
+    // Data-oriented storage of many buttons, knobs and sliders.
+    // States, values, transforms, bounds and texture rectangles live in
+    // contiguous arrays indexed by handle, so event handling, hit tests
+    // and updates are linear loops over packed data (hit tests use
+    // ss::RectBatch and ss::EllipseBatch). Widgets are drawn as quads,
+    // one draw call per run of widgets that share a texture.
+    // It is an alternative store, not a replacement of ss::Button,
+    // ss::Knob and ss::Slider: those are separate objects with virtual
+    // calls, any collision shape and every kind of skin (streaming,
+    // compact, vector, hit masks), which is right for tens of widgets.
+    // The store keeps only what thousands of plain widgets need, so it has
+    // its own small facades (WidgetStore::Button, Knob, Slider): handles
+    // with the common part of the widget interface (bind, freeze, state,
+    // position, value). Quads and nine-slice geometry are built by the
+    // same code as widgets use, so both look the same.
+    // Widgets are addressed by generational handles: slots of destroyed
+    // widgets are recycled through a free list, so creating and destroying
+    // many widgets doesn't allocate, and a stale handle is caught by an
+    // assertion instead of silently referring to a new widget.
+    // Store is a widget itself: it can be added to ss::Gui,
+    // its transform is applied to all of its widgets.
+    class WidgetStore : public AbstractWidget
+    {
+        private:
+            using Callback = std::function<void(void)>;
+            using Index = std::uint32_t;  // Slot in the arrays
+
+
+        public:
+            // Slot index and generation of the slot when widget was created,
+            // handle of a destroyed widget never refers to a new one
+            struct Handle
+            {
+                Index           index;
+                std::uint32_t   generation;
+            };
+
+            class Widget;
+            class Button;
+            class Knob;
+            class Slider;
+
+
+        public:
+                                WidgetStore();
+
+
+        public:
+            // Sprites should have the same texture
+            Button              createButton(const sf::Sprite& idle,
+                                             const sf::Sprite& hover,
+                                             const sf::Sprite& hit);
+            Button              createButton(const ButtonSkin&);
+
+            // Nine-slice skin stretched to the size: nine quads in the same
+            // vertex array (and draw call) as other widgets of the texture
+            Button              createButton(const ButtonSkin&,
+                                             sf::Vector2f size);
+
+            // Spritesheets are the same as ss::Knob and ss::Slider have,
+            // sheet is a rectangle in the texture (whole one if empty)
+            Knob                createKnob(float radius, const sf::Texture&,
+                                           sf::IntRect sheet=sf::IntRect());
+            Slider              createSlider(sf::Vector2f size,
+                                             const sf::Texture&, SliderType,
+                                             sf::IntRect sheet=sf::IntRect());
+
+            // Slot of destroyed widget is reused by the next created one
+            void                destroy(Handle);
+            bool                alive(Handle) const;
+
+            // Number of alive widgets
+            std::size_t         size() const;
+
+            virtual void        handleEvent(const sf::Event&) override;
+
+            // Only widgets changed since the last update are processed
+            virtual void        update(const sf::Window&) override;
+
+            // Store holds the mouse while one of it's widgets is hit
+            virtual bool        grabsMouse() const override;
+            virtual bool        active() const override;
+
+            // Arrays of all widgets are counted as a single widget
+            virtual void        reportMemory(MemoryReport&) const override;
+
+
+        protected:
+            virtual void        draw(sf::RenderTarget&,
+                                    sf::RenderStates) const override;
+
+
+        private:
+            enum Kind : std::uint8_t
+            {
+                ButtonKind,
+                KnobKind,
+                SliderKind,
+                FreeKind,  // Destroyed widget, slot is in the free list
+            };
+
+
+        private:
+            // Free slot with the same number of quads is reused, otherwise
+            // a new slot and it's quads are appended
+            Index               create(Kind, const sf::Texture*, sf::Vector2f,
+                                       std::uint8_t quads=1);
+
+            // Changes state and calls the callback of the new state
+            void                setState(Index, State);
+
+            // Widget will be processed by the next update
+            void                touch(Index);
+
+            bool                hitTest(Index, sf::Vector2f) const;
+
+            // Hover transitions of all widgets for the cursor position
+            void                moveCursor();
+
+            // Value of hit knob or slider follows the cursor
+            void                drag(Index, sf::Vector2f);
+
+            // Current frame of a widget
+            sf::IntRect         textureRect(Index) const;
+
+            void                setBit(RectBatch::Mask&, Index, bool);
+            bool                testBit(const RectBatch::Mask&, Index) const;
+
+
+        private:
+            static constexpr Index NoIndex = ~Index(0);
+
+            // Hot data: used by every event or update
+            std::vector<Kind>   mKinds;  // Free slots are never hit or drawn
+            std::vector<State>  mStates;
+            std::vector<std::uint8_t> mFrozen;
+            std::vector<float>  mValues;  // In range [-1.0; 1.0]
+            std::vector<sf::Vector2f> mPositions;
+            std::vector<sf::Vector2f> mScales;
+            std::vector<sf::Vector2f> mSizes;  // Of collision shapes
+            RectBatch           mBounds;  // Buttons and sliders
+            EllipseBatch        mEllipses;  // Knobs
+            std::vector<sf::Vertex> mVertices;  // Quads of widgets in order
+            std::vector<std::uint32_t> mFirstVertices;  // Of widget quads
+            std::vector<std::uint8_t> mQuadCounts;  // 9 for nine-slice
+
+            // Cold data: used when something changes
+            std::vector<const sf::Texture*> mTextures;
+            // Per state for buttons, spritesheet (Idle) for others
+            std::vector<std::array<sf::IntRect, StateCount>> mStateRects;
+            std::vector<SliderType> mSliderTypes;
+            std::vector<ButtonSkin::Insets> mInsets;  // Nine-slice buttons
+            std::vector<std::array<Callback, StateCount>> mCallbacks;
+            std::vector<std::uint32_t> mGenerations;
+            std::vector<Index>  mFreeSlots;
+
+            // Changed widgets and mouse input
+            std::vector<std::uint8_t> mTouched;
+            std::vector<Index>  mTouchedList;
+            std::vector<Index>  mUpdating;  // Touched list in progress
+            std::vector<Index>  mWaiting;  // Quads built before texture
+            RectBatch::Mask     mHovered;  // Widgets in Hover state
+            RectBatch::Mask     mHits;
+            RectBatch::Mask     mEllipseHits;
+            Index               mCaptured;  // Hit widget or NoIndex
+            sf::Vector2f        mCursor;  // In store local coordinates
+            bool                mCursorInside;
+            float               mPreviousMouseY;  // For knob drag
+    };
+
+    // Handle of a widget in ss::WidgetStore with the interface of ss::Clickable
+    class WidgetStore::Widget
+    {
+        public:
+                                Widget(WidgetStore&, Handle);
+
+
+        public:
+            void                bind(State, Callback);
+            void                freeze(State);
+            void                unfreeze();
+            State               state() const;
+            bool                freezed() const;
+
+            // Widget center as for ss::Button, ss::Knob and ss::Slider
+            void                setPosition(float x, float y);
+            void                setPosition(sf::Vector2f);
+            sf::Vector2f        getPosition() const;
+            void                setScale(float x, float y);
+            void                setScale(sf::Vector2f);
+            sf::Vector2f        getScale() const;
+
+            Handle              handle() const;
+
+
+        protected:
+            // Slot of the widget, handle is checked in debug builds
+            Index               index() const;
+
+
+        protected:
+            WidgetStore*        mStore;
+            Handle              mHandle;
+    };
+
+    class WidgetStore::Button : public WidgetStore::Widget
+    {
+        public:
+            using Widget::Widget;
+    };
+
+    class WidgetStore::Knob : public WidgetStore::Widget
+    {
+        public:
+            using Widget::Widget;
+
+            // The same ranges as ss::Knob has
+            float               value() const;
+            void                setValue(float);
+    };
+
+    class WidgetStore::Slider : public WidgetStore::Widget
+    {
+        public:
+            using Widget::Widget;
+
+            float               value() const;
+            void                setValue(float);
+    };
+
+    // Widgets of each type in their own contiguous vector, for example
+    // ss::WidgetSet<ss::Button, ss::Knob> has a vector of buttons and
+    // a vector of knobs. Events, updates and draws go type by type with
+    // qualified (non-virtual) calls, so the compiler can inline them.
+    // Set is a single widget of ss::Gui: it gets all mouse events and
+    // it's widgets test the cursor themselves (in window coordinates,
+    // transform of the set is not applied to them).
+    // Pointer capture works as in ss::Gui: a press goes to the topmost
+    // widget (the last one of the last type first) until some widget
+    // grabs the mouse, then only that widget gets mouse events and others
+    // lose hover until the release.
+    // Custom widget types should befriend ss::WidgetSet to be drawn
+    template <typename... Ts>
+    class WidgetSet : public AbstractWidget
+    {
+        static_assert((std::is_base_of_v<AbstractWidget, Ts> and ...),
+                      "Only widgets can be stored in ss::WidgetSet");
+
+
+        public:
+                                WidgetSet();
+
+                                // Widgets of a copy belong to the copy
+                                WidgetSet(const WidgetSet&);
+            WidgetSet&          operator=(const WidgetSet&);
+
+
+        public:
+            // Widget is copied to the set. Reference is valid until
+            // another widget of the same type is added (as for std::vector)
+            template <typename T>
+            T&                  add(T widget);
+
+            // Widget of a type is erased, the ones after it move back
+            template <typename T>
+            void                erase(std::size_t index);
+
+            // Widgets of a type in order of addition. They may be changed,
+            // but should be added by add() and erased by erase() (the set
+            // loses the mouse capture otherwise)
+            template <typename T>
+            std::vector<T>&     widgets();
+            template <typename T>
+            const std::vector<T>& widgets() const;
+
+            std::size_t         size() const;
+
+            virtual void        handleEvent(const sf::Event&) override;
+            virtual void        update(const sf::Window&) override;
+
+            // Set holds the mouse while one of it's widgets does
+            virtual bool        grabsMouse() const override;
+            virtual bool        animating() const override;
+
+            // Widgets of the set are reported as they would be without it
+            virtual void        reportMemory(MemoryReport&) const override;
+
+
+        protected:
+            virtual void        draw(sf::RenderTarget&,
+                                    sf::RenderStates) const override;
+
+
+        private:
+            // Calls function for the vector of every type in order of Ts
+            template <typename Tuple, typename F>
+            static void         forEachType(Tuple&, F);
+
+            // Calls function for the widget at a flat index: widgets of
+            // the first type go first, then the ones of the second type...
+            template <typename Tuple, typename F>
+            static void         visit(Tuple&, std::size_t index, F);
+
+            // Position of T in Ts
+            template <typename T>
+            static constexpr std::size_t typeIndex();
+
+            // Flat index of the captured widget, NoWidget if there is none
+            // or widgets of it's type were added or erased behind the set
+            std::size_t         captured() const;
+
+            // Widget at a flat index holds the mouse
+            bool                grabs(std::size_t index) const;
+
+            void                capture(std::size_t index);
+            void                release();
+
+            // Widgets of a type notify the set when they change
+            template <typename T>
+            void                adopt(std::vector<T>&);
+
+
+        private:
+            static constexpr std::size_t NoWidget = ~std::size_t(0);
+
+            std::tuple<std::vector<Ts>...> mWidgets;
+
+            // Captured widget is kept as it's type and index in the vector
+            // of the type, so adding widgets of other types doesn't move it
+            std::size_t         mCapturedType;  // Position in Ts or NoWidget
+            std::size_t         mCapturedIndex;
+            std::size_t         mCapturedCount;  // Widgets of the type
+            sf::Vector2i        mCursor;  // Last cursor position from events
+            bool                mCursorInside;
+    };
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#ifdef SSGUI_IMPL  // Implementation starts here
+
+#ifdef _WIN32  // File mapping of asset packs
+    #ifndef NOMINMAX
+        #define NOMINMAX
+    #endif
+    #ifndef WIN32_LEAN_AND_MEAN
+        #define WIN32_LEAN_AND_MEAN
+    #endif
+    #include <windows.h>
+#else
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+namespace ss
+{
+    AbstractWidget::AbstractWidget()
+    : mGui(nullptr)
+    , mOwner(nullptr)
+    , mUrgent(false)
+    , mIndex(0)
+    {
+    }
+
+    AbstractWidget::AbstractWidget(const AbstractWidget& other)
+    : sf::Drawable(other)
+    , sf::Transformable(other)
+    , mGui(nullptr)
+    , mOwner(nullptr)
+    , mUrgent(false)
+    , mIndex(0)
+    {
+    }
+
+    AbstractWidget& AbstractWidget::operator=(const AbstractWidget& other)
+    {
+        sf::Transformable::operator=(other);
+        return *this;
+    }
+
+    AbstractWidget::~AbstractWidget()
+    {
+        if (mGui)
+            mGui->remove(*this);
+    }
+
+    bool AbstractWidget::grabsMouse() const
+    {
+        return false;
+    }
+
+    Gui* AbstractWidget::gui() const
+    {
+        return mGui;
+    }
+
+    bool AbstractWidget::animating() const
+    {
+        return false;
+    }
+
+    bool AbstractWidget::active() const
+    {
+        return false;
+    }
+
+    sf::FloatRect AbstractWidget::bounds() const
+    {
+        const auto half = std::numeric_limits<float>::max() / 4;
+        return sf::FloatRect(-half, -half, half*2, half*2);
+    }
+
+    std::optional<Ellipse> AbstractWidget::ellipse() const
+    {
+        return std::nullopt;
+    }
+
+    void AbstractWidget::reportMemory(MemoryReport& report) const
+    {
+        report.addWidget("ss::AbstractWidget", sizeof(AbstractWidget));
+    }
+
+    void AbstractWidget::invalidate()
+    {
+        if (mOwner)
+            mOwner->invalidate();
+        else if (mGui)
+            mGui->invalidate(*this);
+    }
+
+    void AbstractWidget::invalidateLayout()
+    {
+        if (mGui)
+            mGui->invalidateLayout(*this);
+    }
+
+    template <typename T>
+    Clickable<T>::Clickable(T collisionShape)
+    : mCollisionShape(std::move(collisionShape))
+    , mState(Idle)
+    , mCallbacks{[](){}, [](){}, [](){}}
+    , mFreezed(false)
+    , mCursor(0, 0)
+    , mCursorInside(false)
+    , mLayoutDirty(true)
+    {
+    }
+
+    template <typename T>
+    void Clickable<T>::bind(State state, Callback callback)
+    {
+        mCallbacks[static_cast<unsigned>(state)] = std::move(callback);
+    }
+
+    template <typename T>
+    void Clickable<T>::freeze(State state)
+    {
+        mState = state;
+        mFreezed = true;
+        invalidate();
+    }
+
+    template <typename T>
+    void Clickable<T>::unfreeze()
+    {
+        mFreezed = false;
+        mLayoutDirty = true;  // Cursor might have moved while frozen
+    }
+
+    template <typename T>
+    void Clickable<T>::handleEvent(const sf::Event& event)
+    {
+        // Cursor is tracked even if widget is frozen to be up to date
+        if (event.type == sf::Event::MouseMoved)
+        {
+            mCursor = sf::Vector2i(event.mouseMove.x, event.mouseMove.y);
+            mCursorInside = true;
+        }
+        else if (event.type == sf::Event::MouseButtonPressed
+            or event.type == sf::Event::MouseButtonReleased)
+        {
+            mCursor = sf::Vector2i(event.mouseButton.x, event.mouseButton.y);
+            mCursorInside = true;
+        }
+        else if (event.type == sf::Event::MouseLeft)
+        {
+            mCursorInside = false;
+        }
+
+        if (mFreezed)
+            return;
+
+        if (event.type == sf::Event::MouseMoved
+            or event.type == sf::Event::MouseLeft)
+        {
+            updateHover();
+        }
+        else if (event.type == sf::Event::MouseButtonPressed)
+        {
+            updateHover();
+
+            if (mState == Hover 
+                and event.mouseButton.button == sf::Mouse::Left)
+            {
+                mState = Hit;
+                call();
+            }
+        }
+        else if (event.type == sf::Event::MouseButtonReleased)
+        {
+            if (mState == Hit
+                and event.mouseButton.button == sf::Mouse::Left)
+            {
+                mState = Hover;
+                call();
+                updateHover();  // Mouse may be released outside of widget
+            }
+        }
+    }
+
+    template <typename T>
+    void Clickable<T>::update([[maybe_unused]] const sf::Window& window)
+    {
+        if (mCollisionShape.getPosition() != getPosition()
+            or mCollisionShape.getScale() != getScale())
+            mLayoutDirty = true;
+
+        if (not mLayoutDirty)
+            return;
+
+        mCollisionShape.setPosition(getPosition());
+        mCollisionShape.setScale(getScale());
+        centerOrigin(mCollisionShape);
+        mLayoutDirty = false;
+        invalidate();
+        invalidateLayout();
+
+        if (not mFreezed)
+            updateHover();
+    }
+
+    template <typename T>
+    bool Clickable<T>::grabsMouse() const
+    {
+        return mState == Hit and not mFreezed;
+    }
+
+    template <typename T>
+    bool Clickable<T>::active() const
+    {
+        return mState != Idle;
+    }
+
+    template <typename T>
+    sf::FloatRect Clickable<T>::bounds() const
+    {
+        return mCollisionShape.getGlobalBounds();
+    }
+
+    template <typename T>
+    std::optional<Ellipse> Clickable<T>::ellipse() const
+    {
+        return ss::ellipse(mCollisionShape);
+    }
+
+    template <typename T>
+    const T& Clickable<T>::collisionShape() const
+    {
+        return mCollisionShape;
+    }
+
+    template <typename T>
+    State Clickable<T>::state() const
+    {
+        return mState;
+    }
+
+    template <typename T>
+    bool Clickable<T>::freezed() const
+    {
+        return mFreezed;
+    }
+
+    template <typename T>
+    const typename Clickable<T>::Callback& Clickable<T>::callback(
+                                                            State state) const
+    {
+        return mCallbacks[static_cast<unsigned>(state)];
+    }
+
+    template <typename T>
+    void Clickable<T>::draw(
+        [[maybe_unused]] sf::RenderTarget& target,
+        [[maybe_unused]] sf::RenderStates states) const
+    {
+    }
+
+    template <typename T>
+    bool Clickable<T>::hitTest(sf::Vector2i point) const
+    {
+        return contains(mCollisionShape, point);
+    }
+
+    template <typename T>
+    void Clickable<T>::reportMemory(MemoryReport& report) const
+    {
+        reportMemory(report, "ss::Clickable", sizeof(Clickable));
+    }
+
+    template <typename T>
+    void Clickable<T>::reportMemory(MemoryReport& report, const char* type,
+                                    std::size_t bytes) const
+    {
+        report.addWidget(type, bytes);
+        report.callbackBytes += sizeof(mCallbacks);
+    }
+
+    template <typename T>
+    void Clickable<T>::call()
+    {
+        invalidate();
+        mCallbacks[static_cast<unsigned>(mState)]();
+    }
+
+    template <typename T>
+    void Clickable<T>::updateHover()
+    {
+        auto cursor = mCursorInside ? std::optional<sf::Vector2i>(mCursor)
+                                    : std::nullopt;
+
+        // Widget in a gui does not get mouse events that are far from it
+        // or captured by another widget, but gui knows the cursor
+        if (gui())
+            cursor = gui()->cursorFor(*this);
+
+        const bool inside = cursor and hitTest(*cursor);
+
+        if (mState == Idle and inside)
+        {
+            mState = Hover;
+            call();
+        }
+        else if (mState == Hover and not inside)
+        {
+            mState = Idle;
+            call();
+        }
+    }
+
+    template <typename T>
+    void centerOrigin(T& object)
+    {
+        const auto rect = object.getLocalBounds();
+        object.setOrigin(   rect.left + static_cast<unsigned>(rect.width)/2,
+                            rect.top  + static_cast<unsigned>(rect.height)/2);
+    }
+
+    template <typename A, typename B>
+    float distance(A a, B b)
+    {
+        return sqrt(pow(a.x-b.x, 2) + pow(a.y-b.y, 2));
+    }
+
+    bool isMouseEvent(const sf::Event& event)
+    {
+        switch (event.type)
+        {
+            case sf::Event::MouseWheelMoved:
+            case sf::Event::MouseWheelScrolled:
+            case sf::Event::MouseButtonPressed:
+            case sf::Event::MouseButtonReleased:
+            case sf::Event::MouseMoved:
+            case sf::Event::MouseEntered:
+            case sf::Event::MouseLeft:
+                return true;
+            default:
+                return false;
+        }
+    }
+
+    bool loaded(const sf::Texture* texture)
+    {
+        return texture and texture->getSize().x and texture->getSize().y;
+    }
+
+    std::uint64_t hash64(const void* data, std::size_t size,
+                         std::uint64_t seed)
+    {
+        constexpr std::uint64_t P1 = 11400714785074694791ull;
+        constexpr std::uint64_t P2 = 14029467366897019727ull;
+        constexpr std::uint64_t P3 = 1609587929392839161ull;
+        constexpr std::uint64_t P4 = 9650029242287828579ull;
+        constexpr std::uint64_t P5 = 2870177450012600261ull;
+
+        const auto rotl = [](std::uint64_t x, int r)
+        {
+            return (x << r) | (x >> (64 - r));
+        };
+        const auto round = [rotl](std::uint64_t acc, std::uint64_t input)
+        {
+            return rotl(acc + input*P2, 31) * P1;
+        };
+        const auto merge = [round](std::uint64_t acc, std::uint64_t value)
+        {
+            return (acc ^ round(0, value))*P1 + P4;
+        };
+
+        // Little-endian reads as the reference implementation does
+        const auto bytes = static_cast<const std::uint8_t*>(data);
+        const auto read = [bytes](std::size_t at, int count)
+        {
+            std::uint64_t value = 0;
+            for (int i = 0; i < count; ++i)
+                value |= std::uint64_t(bytes[at+i]) << i*8;
+            return value;
+        };
+
+        std::size_t at = 0;
+        std::uint64_t hash;
+        if (size >= 32)
+        {
+            std::uint64_t v1 = seed + P1 + P2, v2 = seed + P2;
+            std::uint64_t v3 = seed, v4 = seed - P1;
+            for (; at + 32 <= size; at += 32)
+            {
+                v1 = round(v1, read(at, 8));
+                v2 = round(v2, read(at+8, 8));
+                v3 = round(v3, read(at+16, 8));
+                v4 = round(v4, read(at+24, 8));
+            }
+            hash = rotl(v1, 1) + rotl(v2, 7) + rotl(v3, 12) + rotl(v4, 18);
+            hash = merge(merge(merge(merge(hash, v1), v2), v3), v4);
+        }
+        else
+            hash = seed + P5;
+        hash += size;
+
+        for (; at + 8 <= size; at += 8)
+            hash = rotl(hash ^ round(0, read(at, 8)), 27)*P1 + P4;
+        if (at + 4 <= size)
+        {
+            hash = rotl(hash ^ read(at, 4)*P1, 23)*P2 + P3;
+            at += 4;
+        }
+        for (; at < size; ++at)
+            hash = rotl(hash ^ bytes[at]*P5, 11)*P1;
+
+        hash ^= hash >> 33;
+        hash *= P2;
+        hash ^= hash >> 29;
+        hash *= P3;
+        hash ^= hash >> 32;
+        return hash;
+    }
+
+    sf::IntRect spritesheetFrame(const sf::Texture& texture,
+                                 sf::IntRect sheet, float value)
+    {
+        if (sheet.width <= 0 or sheet.height <= 0)
+            sheet = sf::IntRect(0, 0, texture.getSize().x,
+                                texture.getSize().y);
+        if (sheet.width <= 0)
+            return sf::IntRect();
+
+        const auto frames = std::max(sheet.height / sheet.width, 1);
+        const auto top = sheet.top
+            + roundf((frames - 1)*(value+1.f)/2)*sheet.width;
+        return sf::IntRect(sheet.left, top, sheet.width, sheet.width);
+    }
+
+    template <typename T>
+    bool contains(const T& shape, sf::Vector2i point)
+    {
+        return shape.getGlobalBounds()
+            .contains(static_cast<sf::Vector2f>(point));
+    }
+
+    template <>
+    bool contains<sf::CircleShape>(
+        const sf::CircleShape& shape, sf::Vector2i point)
+    {
+        return contains(*ellipse(shape), static_cast<sf::Vector2f>(point));
+    }
+
+    template <typename T>
+    std::optional<Ellipse> ellipse([[maybe_unused]] const T& shape)
+    {
+        return std::nullopt;
+    }
+
+    template <>
+    std::optional<Ellipse> ellipse<sf::CircleShape>(
+                                                const sf::CircleShape& shape)
+    {
+        const auto radius = shape.getRadius();
+        const auto scale = shape.getScale();
+        return Ellipse{
+            shape.getTransform().transformPoint(radius, radius),
+            sf::Vector2f(radius * std::abs(scale.x),
+                         radius * std::abs(scale.y))};
+    }
+
+    bool contains(const Ellipse& ellipse, sf::Vector2f point)
+    {
+        const float dx = (point.x - ellipse.center.x) * (1.f/ellipse.radii.x);
+        const float dy = (point.y - ellipse.center.y) * (1.f/ellipse.radii.y);
+#ifdef __FMA__  // The same rounding as the vector code
+        return std::fma(dx, dx, dy*dy) < 1.f;
+#else
+        return dx*dx + dy*dy < 1.f;
+#endif
+    }
+
+    namespace detail
+    {
+    // Appends edge equations of a transformed convex polygon
+    void halfPlanes(const sf::Vector2f* points, std::size_t count,
+                    const sf::Transform& transform,
+                    std::vector<HalfPlane>& edges)
+    {
+        // Signed area tells the order of points after transformation
+        float area = 0.f;
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            const auto p = transform.transformPoint(points[i]);
+            const auto q = transform.transformPoint(points[(i+1) % count]);
+            area += p.x*q.y - q.x*p.y;
+        }
+        const float sign = area < 0.f ? -1.f : 1.f;
+
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            const auto p = transform.transformPoint(points[i]);
+            const auto q = transform.transformPoint(points[(i+1) % count]);
+            const float a = (p.y - q.y) * sign;
+            const float b = (q.x - p.x) * sign;
+            edges.push_back(HalfPlane{a, b, -(a*p.x + b*p.y)});
+        }
+    }
+
+    bool inside(const HalfPlane* edges, std::size_t count, sf::Vector2f point)
+    {
+        for (std::size_t i = 0; i < count; ++i)
+            if (edges[i].a*point.x + edges[i].b*point.y + edges[i].c < 0.f)
+                return false;
+        return count > 0;
+    }
+
+    bool sameTransform(const sf::Transform& a, const sf::Transform& b)
+    {
+        return std::equal(a.getMatrix(), a.getMatrix() + 16, b.getMatrix());
+    }
+
+    sf::FloatRect boundsOf(const sf::Vector2f* points, std::size_t count)
+    {
+        if (count == 0)
+            return sf::FloatRect();
+
+        sf::Vector2f min = points[0];
+        sf::Vector2f max = points[0];
+        for (std::size_t i = 1; i < count; ++i)
+        {
+            min.x = std::min(min.x, points[i].x);
+            min.y = std::min(min.y, points[i].y);
+            max.x = std::max(max.x, points[i].x);
+            max.y = std::max(max.y, points[i].y);
+        }
+        return sf::FloatRect(min, max - min);
+    }
+
+    sf::FloatRect unite(const sf::FloatRect& a, const sf::FloatRect& b)
+    {
+        if (a.width == 0 and a.height == 0)
+            return b;
+
+        const auto left = std::min(a.left, b.left);
+        const auto top = std::min(a.top, b.top);
+        return sf::FloatRect(left, top,
+            std::max(a.left + a.width, b.left + b.width) - left,
+            std::max(a.top + a.height, b.top + b.height) - top);
+    }
+
+    }  // namespace detail
+
+    ConvexPolygon::ConvexPolygon(std::vector<sf::Vector2f> points)
+    : mPoints(std::move(points))
+    , mLocalBounds(detail::boundsOf(mPoints.data(), mPoints.size()))
+    , mEdgesValid(false)
+    {
+        assert(mPoints.size() >= 3 or mPoints.empty());
+    }
+
+    const std::vector<sf::Vector2f>& ConvexPolygon::points() const
+    {
+        return mPoints;
+    }
+
+    sf::FloatRect ConvexPolygon::getLocalBounds() const
+    {
+        return mLocalBounds;
+    }
+
+    sf::FloatRect ConvexPolygon::getGlobalBounds() const
+    {
+        return getTransform().transformRect(mLocalBounds);
+    }
+
+    bool ConvexPolygon::contains(sf::Vector2f point) const
+    {
+        if (not mEdgesValid or not detail::sameTransform(mEdgesTransform,
+                                                         getTransform()))
+        {
+            mEdges.clear();
+            detail::halfPlanes(mPoints.data(), mPoints.size(),
+                               getTransform(), mEdges);
+            mEdgesTransform = getTransform();
+            mEdgesValid = true;
+        }
+
+        return detail::inside(mEdges.data(), mEdges.size(), point);
+    }
+
+    CompoundShape::CompoundShape()
+    : mEdgesValid(false)
+    {
+    }
+
+    void CompoundShape::add(const ConvexPolygon& polygon)
+    {
+        assert(polygon.points().size() >= 3);
+        for (const auto& point : polygon.points())
+            mPoints.push_back(polygon.getTransform().transformPoint(point));
+        mPolygonSizes.push_back(polygon.points().size());
+        mLocalBounds = detail::unite(mLocalBounds,
+            detail::boundsOf(&*(mPoints.end() - mPolygonSizes.back()),
+                             mPolygonSizes.back()));
+        mEdgesValid = false;
+    }
+
+    void CompoundShape::add(const sf::FloatRect& rect)
+    {
+        add(ConvexPolygon({
+            sf::Vector2f(rect.left, rect.top),
+            sf::Vector2f(rect.left + rect.width, rect.top),
+            sf::Vector2f(rect.left + rect.width, rect.top + rect.height),
+            sf::Vector2f(rect.left, rect.top + rect.height)}));
+    }
+
+    void CompoundShape::add(sf::Vector2f center, float radius)
+    {
+        mCircles.push_back(Circle{center, radius});
+        mLocalBounds = detail::unite(mLocalBounds, sf::FloatRect(
+            center.x - radius, center.y - radius, radius*2, radius*2));
+    }
+
+    sf::FloatRect CompoundShape::getLocalBounds() const
+    {
+        return mLocalBounds;
+    }
+
+    sf::FloatRect CompoundShape::getGlobalBounds() const
+    {
+        return getTransform().transformRect(mLocalBounds);
+    }
+
+    bool CompoundShape::contains(sf::Vector2f point) const
+    {
+        if (not mEdgesValid or not detail::sameTransform(mEdgesTransform,
+                                                         getTransform()))
+        {
+            mEdges.clear();
+            std::size_t first = 0;
+            for (auto size : mPolygonSizes)
+            {
+                detail::halfPlanes(&mPoints[first], size, getTransform(),
+                                   mEdges);
+                first += size;
+            }
+            mEdgesTransform = getTransform();
+            mEdgesValid = true;
+        }
+
+        // Polygon i has as many edges as points
+        std::size_t first = 0;
+        for (auto size : mPolygonSizes)
+        {
+            if (detail::inside(&mEdges[first], size, point))
+                return true;
+            first += size;
+        }
+
+        // Circles are tested in local coordinates (exact for any transform)
+        const auto local = getInverseTransform().transformPoint(point);
+        for (const auto& circle : mCircles)
+        {
+            const float dx = local.x - circle.center.x;
+            const float dy = local.y - circle.center.y;
+            if (dx*dx + dy*dy < circle.radius*circle.radius)
+                return true;
+        }
+        return false;
+    }
+
+    template <>
+    bool contains<ConvexPolygon>(
+        const ConvexPolygon& shape, sf::Vector2i point)
+    {
+        return shape.contains(static_cast<sf::Vector2f>(point));
+    }
+
+    template <>
+    bool contains<CompoundShape>(
+        const CompoundShape& shape, sf::Vector2i point)
+    {
+        return shape.contains(static_cast<sf::Vector2f>(point));
+    }
+
+    RectShape::RectShape(sf::Vector2f size)
+    : mSize(size)
+    , mPosition(0.f, 0.f)
+    , mScale(1.f, 1.f)
+    , mOrigin(0.f, 0.f)
+    {
+    }
+
+    const sf::Vector2f& RectShape::getSize() const
+    {
+        return mSize;
+    }
+
+    const sf::Vector2f& RectShape::getPosition() const
+    {
+        return mPosition;
+    }
+
+    const sf::Vector2f& RectShape::getScale() const
+    {
+        return mScale;
+    }
+
+    const sf::Vector2f& RectShape::getOrigin() const
+    {
+        return mOrigin;
+    }
+
+    void RectShape::setPosition(sf::Vector2f position)
+    {
+        mPosition = position;
+    }
+
+    void RectShape::setScale(sf::Vector2f scale)
+    {
+        mScale = scale;
+    }
+
+    void RectShape::setOrigin(float x, float y)
+    {
+        mOrigin = sf::Vector2f(x, y);
+    }
+
+    sf::FloatRect RectShape::getLocalBounds() const
+    {
+        return sf::FloatRect(sf::Vector2f(0.f, 0.f), mSize);
+    }
+
+    sf::FloatRect RectShape::getGlobalBounds() const
+    {
+        // Corners may swap with a negative scale
+        const auto a = mPosition + sf::Vector2f(-mOrigin.x*mScale.x,
+                                                -mOrigin.y*mScale.y);
+        const auto b = a + sf::Vector2f(mSize.x*mScale.x, mSize.y*mScale.y);
+        const sf::Vector2f min(std::min(a.x, b.x), std::min(a.y, b.y));
+        const sf::Vector2f max(std::max(a.x, b.x), std::max(a.y, b.y));
+        return sf::FloatRect(min, max - min);
+    }
+
+    sf::Vector2f RectShape::toLocal(sf::Vector2f point) const
+    {
+        return sf::Vector2f((point.x - mPosition.x)/mScale.x + mOrigin.x,
+                            (point.y - mPosition.y)/mScale.y + mOrigin.y);
+    }
+
+    HitMask::HitMask(const sf::Image& image, std::uint8_t threshold)
+    : mSize(image.getSize())
+    , mBits((mSize.x*mSize.y + 63) / 64, 0)
+    {
+        const auto pixels = image.getPixelsPtr();
+        for (std::size_t i = 0; i < std::size_t(mSize.x)*mSize.y; ++i)
+            if (pixels[i*4 + 3] >= threshold)
+                mBits[i / 64] |= std::uint64_t(1) << (i % 64);
+    }
+
+    HitMask::HitMask(sf::Vector2u size, std::vector<std::uint64_t> bits)
+    : mSize(size)
+    , mBits(std::move(bits))
+    {
+        assert(mBits.size() == (mSize.x*mSize.y + 63) / 64);
+    }
+
+    std::shared_ptr<const HitMask> HitMask::of(const sf::Texture& texture)
+    {
+        // Address of a destroyed texture can be taken by a new one, so
+        // the entry also remembers the OpenGL name it was built from
+        struct Entry
+        {
+            std::weak_ptr<const HitMask> mask;
+            unsigned            handle = 0;
+        };
+        static std::map<const sf::Texture*, Entry> masks;
+        static std::mutex mutex;
+
+        std::lock_guard<std::mutex> lock(mutex);
+        for (auto i = masks.begin(); i != masks.end();)
+            if (i->second.mask.expired())
+                i = masks.erase(i);
+            else
+                ++i;
+
+        auto& entry = masks[&texture];
+        auto mask = entry.mask.lock();
+        if (not mask or entry.handle != texture.getNativeHandle()
+            or mask->size() != texture.getSize())
+        {
+            mask = std::make_shared<const HitMask>(texture.copyToImage());
+            entry = Entry{mask, texture.getNativeHandle()};
+        }
+        return mask;
+    }
+
+    bool HitMask::opaque(int x, int y) const
+    {
+        if (x < 0 or y < 0
+            or unsigned(x) >= mSize.x or unsigned(y) >= mSize.y)
+            return false;
+
+        const auto i = std::size_t(y)*mSize.x + unsigned(x);
+        return (mBits[i / 64] >> (i % 64)) & 1u;
+    }
+
+    sf::Vector2u HitMask::size() const
+    {
+        return mSize;
+    }
+
+    std::size_t HitMask::bytes() const
+    {
+        return mBits.capacity() * sizeof(std::uint64_t);
+    }
+
+    ButtonSkin::ButtonSkin(const sf::Texture& texture, sf::IntRect idle,
+                           sf::IntRect hover, sf::IntRect hit, Insets insets)
+    : mTexture(&texture)
+    , mRects{idle, hover, hit}
+    , mInsets(insets)
+    {
+        assert(insetsFit());
+    }
+
+    ButtonSkin::ButtonSkin(std::shared_ptr<const sf::Texture> texture,
+                           sf::IntRect idle, sf::IntRect hover,
+                           sf::IntRect hit, Insets insets)
+    : mTexture(texture.get())
+    , mHandle(std::move(texture))
+    , mRects{idle, hover, hit}
+    , mInsets(insets)
+    {
+        assert(insetsFit());
+    }
+
+    ButtonSkin::ButtonSkin(const sf::Sprite& idle, const sf::Sprite& hover,
+                           const sf::Sprite& hit, Insets insets)
+    : mTexture(idle.getTexture())
+    , mRects{idle.getTextureRect(), hover.getTextureRect(),
+             hit.getTextureRect()}
+    , mInsets(insets)
+    {
+        assert(hover.getTexture() == mTexture and hit.getTexture() == mTexture);
+        assert(insetsFit());
+    }
+
+    const sf::Texture* ButtonSkin::texture() const
+    {
+        return mTexture;
+    }
+
+    const sf::IntRect& ButtonSkin::rect(State state) const
+    {
+        return mRects[static_cast<unsigned>(state)];
+    }
+
+    const ButtonSkin::Insets& ButtonSkin::insets() const
+    {
+        return mInsets;
+    }
+
+    bool ButtonSkin::nineSlice() const
+    {
+        return mInsets.left or mInsets.top or mInsets.right or mInsets.bottom;
+    }
+
+    bool ButtonSkin::insetsFit() const
+    {
+        return std::all_of(std::begin(mRects), std::end(mRects),
+            [this](const sf::IntRect& rect)
+            {
+                return mInsets.left + mInsets.right
+                        <= unsigned(std::abs(rect.width))
+                    and mInsets.top + mInsets.bottom
+                        <= unsigned(std::abs(rect.height));
+            });
+    }
+
+    CompactSheet::CompactSheet(const sf::Image& image)
+    : mSize(image.getSize().x)
+    , mUniqueCount(0)
+    {
+        const auto count = mSize ? image.getSize().y / mSize : 0;
+        const auto pixels = image.getPixelsPtr();
+        const auto alpha = [&](unsigned frame, unsigned x, unsigned y)
+        {
+            return pixels[((std::size_t(frame)*mSize + y)*mSize + x)*4 + 3];
+        };
+
+        // Trimmed pixels of unique frames, the same hash is a candidate
+        struct Unique
+        {
+            std::vector<std::uint8_t> pixels;
+            sf::IntRect rect;
+        };
+        std::vector<Unique> uniques;
+        std::multimap<std::uint64_t, std::size_t> hashes;  // Unique index
+        unsigned width = 0, height = 0;
+        for (unsigned i = 0; i < count; ++i)
+        {
+            // Non-transparent bounds of the frame
+            unsigned left = mSize, top = mSize, right = 0, bottom = 0;
+            for (unsigned y = 0; y < mSize; ++y)
+                for (unsigned x = 0; x < mSize; ++x)
+                    if (alpha(i, x, y))
+                    {
+                        left = std::min(left, x);
+                        right = std::max(right, x + 1);
+                        top = std::min(top, y);
+                        bottom = std::max(bottom, y + 1);
+                    }
+            if (left >= right)
+            {
+                mFrames.push_back(Frame{sf::IntRect(), {0, 0}});
+                continue;
+            }
+
+            const auto w = right - left, h = bottom - top;
+            std::vector<std::uint8_t> trimmed(std::size_t(w)*h*4);
+            for (unsigned y = 0; y < h; ++y)
+                std::memcpy(&trimmed[std::size_t(y)*w*4],
+                            pixels + ((std::size_t(i)*mSize + top + y)*mSize
+                                      + left)*4, std::size_t(w)*4);
+
+            // Frames with the same pixels share a rectangle, their offsets
+            // may differ
+            const auto hash = hash64(trimmed.data(), trimmed.size(),
+                                     std::uint64_t(w) << 32 | h);
+            auto [first, last] = hashes.equal_range(hash);
+            while (first != last and uniques[first->second].pixels != trimmed)
+                ++first;
+
+            auto unique = first != last ? first->second : uniques.size();
+            if (unique == uniques.size())
+            {
+                uniques.push_back(Unique{std::move(trimmed),
+                                         sf::IntRect(0, height, w, h)});
+                hashes.emplace(hash, unique);
+                width = std::max(width, w);
+                height += h + AtlasPadding;
+            }
+            mFrames.push_back(Frame{uniques[unique].rect,
+                                    sf::Vector2i(left, top)});
+        }
+
+        // Unique frames one under another
+        mUniqueCount = uniques.size();
+        if (mUniqueCount == 0)
+            return;
+        std::vector<std::uint8_t> compacted(std::size_t(width)*height*4, 0);
+        for (const auto& [trimmed, rect] : uniques)
+            for (int y = 0; y < rect.height; ++y)
+                std::memcpy(&compacted[std::size_t(rect.top + y)*width*4],
+                            &trimmed[std::size_t(y)*rect.width*4],
+                            std::size_t(rect.width)*4);
+        sf::Image result;
+        result.create(width, height, compacted.data());
+        mTexture.loadFromImage(result);
+    }
+
+    const CompactSheet::Frame& CompactSheet::frame(float value) const
+    {
+        static const Frame none{sf::IntRect(), {0, 0}};
+        if (mFrames.empty())
+            return none;
+
+        const auto index = static_cast<std::size_t>(roundf(
+            (mFrames.size() - 1)*(fmax(-1.f, fmin(value, 1.f))+1.f)/2));
+        return mFrames[index];
+    }
+
+    const sf::Texture& CompactSheet::texture() const
+    {
+        return mTexture;
+    }
+
+    unsigned CompactSheet::frameSize() const
+    {
+        return mSize;
+    }
+
+    unsigned CompactSheet::frameCount() const
+    {
+        return mFrames.size();
+    }
+
+    unsigned CompactSheet::uniqueCount() const
+    {
+        return mUniqueCount;
+    }
+
+    namespace detail
+    {
+    // Quad (sf::Quads) of a texture rectangle from min to max corner,
+    // rectangle of negative size is mirrored as sprites do it
+    void frameQuad(sf::Vertex* quad, sf::Vector2f min, sf::Vector2f max,
+                   sf::IntRect rect, sf::Color color)
+    {
+        const float left = rect.left;
+        const float top = rect.top;
+        const float right = rect.left + rect.width;
+        const float bottom = rect.top + rect.height;
+        quad[0] = sf::Vertex({min.x, min.y}, color, {left, top});
+        quad[1] = sf::Vertex({max.x, min.y}, color, {right, top});
+        quad[2] = sf::Vertex({max.x, max.y}, color, {right, bottom});
+        quad[3] = sf::Vertex({min.x, max.y}, color, {left, bottom});
+    }
+
+    // Nine quads (sf::Quads) of a nine-slice skin from min to max corner:
+    // corners are insets times scale, edges and center stretch between
+    // them. Corners shrink if the area is smaller than them. Mirrored
+    // areas (min > max) and rectangles (negative size) are fine
+    void nineSlice(sf::Vertex* quads, sf::Vector2f min, sf::Vector2f max,
+                   sf::IntRect rect, const ButtonSkin::Insets& insets,
+                   sf::Vector2f scale, sf::Color color)
+    {
+        // Lines of the grid along an axis, sides go inwards from the ends
+        const auto lines = [](float from, float to, float a, float b)
+        {
+            const auto length = std::abs(to - from);
+            const auto fit = a + b > length ? length / (a + b) : 1.f;
+            const auto inwards = (to < from ? -1.f : 1.f) * fit;
+            return std::array<float, 4>{
+                from, from + a*inwards, to - b*inwards, to};
+        };
+
+        const auto x = lines(min.x, max.x, insets.left*std::abs(scale.x),
+                             insets.right*std::abs(scale.x));
+        const auto y = lines(min.y, max.y, insets.top*std::abs(scale.y),
+                             insets.bottom*std::abs(scale.y));
+        const auto u = lines(rect.left, rect.left + rect.width,
+                             insets.left, insets.right);
+        const auto v = lines(rect.top, rect.top + rect.height,
+                             insets.top, insets.bottom);
+
+        for (unsigned row = 0; row < 3; ++row)
+            for (unsigned column = 0; column < 3; ++column)
+            {
+                const auto l = column, r = column + 1;
+                const auto t = row, b = row + 1;
+                *quads++ = sf::Vertex({x[l], y[t]}, color, {u[l], v[t]});
+                *quads++ = sf::Vertex({x[r], y[t]}, color, {u[r], v[t]});
+                *quads++ = sf::Vertex({x[r], y[b]}, color, {u[r], v[b]});
+                *quads++ = sf::Vertex({x[l], y[b]}, color, {u[l], v[b]});
+            }
+    }
+
+    constexpr float Pi = 3.14159265f;
+
+    // Geometry of vector skins, arrays are sf::TriangleStrip centered at
+    // zero and their parts are joined by degenerate triangles.
+    // Angles are in radians from the top clockwise (as knob turns)
+    void startPart(sf::VertexArray& array, const sf::Vertex& first)
+    {
+        const auto count = array.getVertexCount();
+        if (count == 0)
+            return;
+        array.append(array[count - 1]);
+        array.append(first);
+    }
+
+    void appendQuad(sf::VertexArray& array, sf::Vector2f a, sf::Vector2f b,
+                    sf::Vector2f c, sf::Vector2f d, sf::Color color)
+    {
+        startPart(array, sf::Vertex(a, color));
+        for (auto point : {a, b, d, c})
+            array.append(sf::Vertex(point, color));
+    }
+
+    void appendRect(sf::VertexArray& array, sf::FloatRect rect,
+                    sf::Color color)
+    {
+        const auto right = rect.left + rect.width;
+        const auto bottom = rect.top + rect.height;
+        appendQuad(array, {rect.left, rect.top}, {right, rect.top},
+                   {right, bottom}, {rect.left, bottom}, color);
+    }
+
+    void appendLine(sf::VertexArray& array, sf::Vector2f from,
+                    sf::Vector2f to, float thickness, sf::Color color)
+    {
+        const auto length = distance(from, to);
+        if (length == 0.f)
+            return;
+        const auto side = sf::Vector2f(from.y - to.y, to.x - from.x)
+            * (thickness/2/length);
+        appendQuad(array, from + side, to + side, to - side, from - side,
+                   color);
+    }
+
+    // Polygon of the circle zigzags from side to side: 0, n-1, 1, n-2...
+    void appendDisc(sf::VertexArray& array, float radius, sf::Color color)
+    {
+        const auto point = [radius](unsigned i)
+        {
+            const float angle = 2*Pi*i/VectorCircleSegments;
+            return sf::Vector2f(std::sin(angle), -std::cos(angle))*radius;
+        };
+        startPart(array, sf::Vertex(point(0), color));
+        for (unsigned i = 0; i < VectorCircleSegments; ++i)
+            array.append(sf::Vertex(point(
+                i % 2 ? VectorCircleSegments - 1 - i/2 : i/2), color));
+    }
+
+    // Arc of thickness around the circle of radius
+    void appendArc(sf::VertexArray& array, float radius, float thickness,
+                   float from, float to, sf::Color color)
+    {
+        if (to <= from)
+            return;
+
+        const auto segments = static_cast<unsigned>(
+            std::ceil((to - from)/(2*Pi)*VectorCircleSegments));
+        const auto inner = radius - thickness/2;
+        const auto outer = radius + thickness/2;
+        for (unsigned i = 0; i <= segments; ++i)
+        {
+            const float angle = from + (to - from)*i/segments;
+            const auto direction = sf::Vector2f(std::sin(angle),
+                                                -std::cos(angle));
+            const sf::Vertex first(direction*inner, color);
+            if (i == 0)
+                startPart(array, first);
+            array.append(first);
+            array.append(sf::Vertex(direction*outer, color));
+        }
+    }
+
+    // Body is built once for a look and shared while some widget uses it,
+    // looks nobody uses are forgotten. Kind is -1 for knobs (size is
+    // the radius) and ss::SliderType for sliders
+    std::shared_ptr<const VectorBody> sharedBody(
+        const VectorSkin& skin, int kind, sf::Vector2f size,
+        const std::function<void(sf::VertexArray&)>& build)
+    {
+        using Key = std::tuple<int, std::uint32_t, std::uint32_t,
+                               std::uint32_t, std::uint32_t,
+                               float, float, float>;
+        static std::map<Key, std::weak_ptr<const VectorBody>> bodies;
+        static std::mutex mutex;
+
+        const auto pack = [](sf::Color color)
+        {
+            return std::uint32_t(color.r) << 24 | std::uint32_t(color.g) << 16
+                | std::uint32_t(color.b) << 8 | color.a;
+        };
+        const Key key(kind, pack(skin.body), pack(skin.track),
+                      pack(skin.value), pack(skin.indicator),
+                      skin.thickness, size.x, size.y);
+
+        std::lock_guard<std::mutex> lock(mutex);
+        for (auto i = bodies.begin(); i != bodies.end();)
+            if (i->second.expired())
+                i = bodies.erase(i);
+            else
+                ++i;
+
+        auto& weak = bodies[key];
+        auto body = weak.lock();
+        if (not body)
+        {
+            auto built = std::make_shared<VectorBody>(
+                VectorBody{skin, sf::VertexArray(sf::TriangleStrip)});
+            build(built->vertices);
+            body = std::move(built);
+            weak = body;
+        }
+        return body;
+    }
+
+    VectorGeometry knobGeometry(const VectorSkin& skin, float radius)
+    {
+        const auto body = sharedBody(skin, -1, sf::Vector2f(radius, radius),
+            [&skin, radius](sf::VertexArray& vertices)
+            {
+                const float sweep = VectorKnobSweep * Pi/180;
+                appendDisc(vertices, radius, skin.body);
+                appendArc(vertices, radius - skin.thickness*1.5f,
+                          skin.thickness, -sweep, sweep, skin.track);
+            });
+        return VectorGeometry{body, sf::VertexArray(sf::TriangleStrip), 0.f};
+    }
+
+    void buildKnobValue(VectorGeometry& geometry, float radius, float value)
+    {
+        const auto& skin = geometry.body->skin;
+        const float sweep = VectorKnobSweep * Pi/180;
+        const float angle = sweep*value;
+
+        geometry.value.clear();
+        appendArc(geometry.value, radius - skin.thickness*1.5f,
+                  skin.thickness, -sweep, angle, skin.value);
+
+        // Indicator from the middle of the knob to the arc
+        const auto direction = sf::Vector2f(std::sin(angle), -std::cos(angle));
+        appendLine(geometry.value, direction*(radius*0.3f),
+                   direction*(radius - skin.thickness*3), skin.thickness,
+                   skin.indicator);
+        geometry.valueBuilt = value;
+    }
+
+    VectorGeometry sliderGeometry(const VectorSkin& skin, sf::Vector2f size,
+                                  SliderType type)
+    {
+        const auto body = sharedBody(skin, type, size,
+            [&skin, size, type](sf::VertexArray& vertices)
+            {
+                const auto t = skin.thickness;
+                appendRect(vertices, sf::FloatRect(-size/2.f, size),
+                           skin.body);
+                if (type == Horizontal)
+                    appendRect(vertices, sf::FloatRect(-size.x/2 + t, -t/2,
+                                                       size.x - 2*t, t),
+                               skin.track);
+                else
+                    appendRect(vertices, sf::FloatRect(-t/2, -size.y/2 + t,
+                                                       t, size.y - 2*t),
+                               skin.track);
+            });
+        return VectorGeometry{body, sf::VertexArray(sf::TriangleStrip), 0.f};
+    }
+
+    void buildSliderValue(VectorGeometry& geometry, sf::Vector2f size,
+                          SliderType type, float value)
+    {
+        const auto& skin = geometry.body->skin;
+        const auto t = skin.thickness;
+        const float progress = (value + 1.f)/2;
+
+        // Groove is filled from the left or the bottom up to the handle
+        geometry.value.clear();
+        if (type == Horizontal)
+        {
+            const float x = -size.x/2 + t + progress*(size.x - 2*t);
+            appendRect(geometry.value, sf::FloatRect(-size.x/2 + t, -t/2,
+                                                     x + size.x/2 - t, t),
+                       skin.value);
+            appendRect(geometry.value, sf::FloatRect(x - t, -size.y/2 + t/2,
+                                                     2*t, size.y - t),
+                       skin.indicator);
+        }
+        else
+        {
+            const float y = size.y/2 - t - progress*(size.y - 2*t);
+            appendRect(geometry.value,
+                       sf::FloatRect(-t/2, y, t, size.y/2 - t - y),
+                       skin.value);
+            appendRect(geometry.value, sf::FloatRect(-size.x/2 + t/2, y - t,
+                                                     size.x - t, 2*t),
+                       skin.indicator);
+        }
+        geometry.valueBuilt = value;
+    }
+
+    // Knob or slider skin for value in local coordinates of the widget:
+    // a frame is centered as ss::centerOrigin centers sprites, a trimmed
+    // frame of a compact sheet is placed where it is in the whole frame.
+    // False if a placeholder should be drawn (texture is not loaded)
+    bool drawSkin(const WidgetSkin& skin, float value,
+                  sf::RenderTarget& target, sf::RenderStates states)
+    {
+        if (const auto vector = std::get_if<VectorGeometry>(&skin))
+        {
+            target.draw(vector->body->vertices, states);
+            target.draw(vector->value, states);
+            return true;
+        }
+
+        const auto centered = [](sf::IntRect rect)
+        {
+            return sf::Vector2f(static_cast<unsigned>(std::abs(rect.width))/2,
+                                static_cast<unsigned>(std::abs(rect.height))/2);
+        };
+
+        const sf::Texture* texture = nullptr;
+        sf::IntRect rect;
+        sf::Vector2f origin;
+        if (const auto sheet = std::get_if<TextureSheet>(&skin))
+        {
+            texture = sheet->texture;
+            if (loaded(texture))
+                rect = spritesheetFrame(*texture, sheet->sheet, value);
+            origin = centered(rect);
+        }
+        else if (const auto stream =
+                 std::get_if<std::shared_ptr<StreamingSheet>>(&skin))
+        {
+            // Frame is uploaded right before it is drawn
+            texture = &(*stream)->texture();
+            if (loaded(texture))
+                rect = (*stream)->frame(value);
+            origin = centered(rect);
+        }
+        else if (const auto compact =
+                 std::get_if<std::shared_ptr<const CompactSheet>>(&skin))
+        {
+            texture = &(*compact)->texture();
+            const auto& frame = (*compact)->frame(value);
+            const auto half = static_cast<float>((*compact)->frameSize()/2);
+            rect = frame.rect;
+            origin = sf::Vector2f(half - frame.offset.x,
+                                  half - frame.offset.y);
+        }
+        if (not loaded(texture))
+            return false;
+
+        sf::Vertex quad[4];
+        const auto size = sf::Vector2f(std::abs(rect.width),
+                                       std::abs(rect.height));
+        frameQuad(quad, -origin, size - origin, rect, sf::Color::White);
+        states.texture = texture;
+        target.draw(quad, 4, sf::Quads, states);
+        return true;
+    }
+
+    // Adds textures and shared data of a skin to the report,
+    // returns bytes that belong to the widget itself
+    std::size_t reportSkin(const WidgetSkin& skin, MemoryReport& report)
+    {
+        if (const auto sheet = std::get_if<TextureSheet>(&skin))
+        {
+            report.addTexture(sheet->texture);
+        }
+        else if (const auto stream =
+                 std::get_if<std::shared_ptr<StreamingSheet>>(&skin))
+        {
+            report.addTexture(&(*stream)->texture());
+            report.addShared(stream->get(),
+                             sizeof(StreamingSheet) + (*stream)->bytes());
+        }
+        else if (const auto compact =
+                 std::get_if<std::shared_ptr<const CompactSheet>>(&skin))
+        {
+            report.addTexture(&(*compact)->texture());
+            report.addShared(compact->get(), sizeof(CompactSheet)
+                + (*compact)->frameCount() * sizeof(CompactSheet::Frame));
+        }
+        else if (const auto vector = std::get_if<VectorGeometry>(&skin))
+        {
+            report.addShared(vector->body.get(), sizeof(VectorBody)
+                + vector->body->vertices.getVertexCount()
+                  * sizeof(sf::Vertex));
+            return vector->value.getVertexCount() * sizeof(sf::Vertex);
+        }
+        return 0;
+    }
+
+    }  // namespace detail
+
+    StreamingSheet::StreamingSheet(const sf::Image& image, unsigned slots)
+    : mSize(image.getSize().x)
+    , mFrames(mSize ? std::max(image.getSize().y / mSize, 1u) : 0)
+    , mUses(0)
+    , mUploads(0)
+    {
+        if (mFrames == 0 or image.getSize().y < mSize)
+        {
+            mFrames = 0;
+            return;
+        }
+
+        const auto pixels = image.getPixelsPtr();
+        mPixels.assign(pixels, pixels + std::size_t(mSize)*mSize*mFrames*4);
+
+        const auto count = std::min(std::max(slots, 1u), mFrames);
+        if (mTexture.create(mSize, mSize*count))
+        {
+            mSlotFrames.assign(count, mFrames);
+            mSlotUses.assign(count, 0);
+        }
+    }
+
+    sf::IntRect StreamingSheet::frame(float value)
+    {
+        if (mSlotFrames.empty())
+            return sf::IntRect();
+
+        const auto index = static_cast<unsigned>(
+            roundf((mFrames - 1)*(fmax(-1.f, fmin(value, 1.f))+1.f)/2));
+        auto slot = std::find(mSlotFrames.begin(), mSlotFrames.end(), index)
+            - mSlotFrames.begin();
+        if (std::size_t(slot) == mSlotFrames.size())
+        {
+            slot = std::min_element(mSlotUses.begin(), mSlotUses.end())
+                - mSlotUses.begin();
+            mTexture.update(&mPixels[std::size_t(index)*mSize*mSize*4],
+                            mSize, mSize, 0, slot*mSize);
+            mSlotFrames[slot] = index;
+            ++mUploads;
+        }
+
+        mSlotUses[slot] = ++mUses;
+        return sf::IntRect(0, slot*mSize, mSize, mSize);
+    }
+
+    const sf::Texture& StreamingSheet::texture() const
+    {
+        return mTexture;
+    }
+
+    unsigned StreamingSheet::frameSize() const
+    {
+        return mSize;
+    }
+
+    unsigned StreamingSheet::frameCount() const
+    {
+        return mFrames;
+    }
+
+    std::size_t StreamingSheet::uploads() const
+    {
+        return mUploads;
+    }
+
+    std::size_t StreamingSheet::bytes() const
+    {
+        return mPixels.capacity();
+    }
+
+    Button::Button(sf::Sprite idle, sf::Sprite hover, sf::Sprite hit)
+    : Button(std::make_shared<const ButtonSkin>(idle, hover, hit))
+    {
+    }
+
+    Button::Button(std::shared_ptr<const ButtonSkin> skin)
+    : Clickable(RectShape(sf::Vector2f(std::abs(skin->rect(Idle).width),
+                                       std::abs(skin->rect(Idle).height))))
+    , mSkin(std::move(skin))
+    {
+    }
+
+    Button::Button(std::shared_ptr<const ButtonSkin> skin, sf::Vector2f size)
+    : Clickable(RectShape(sf::Vector2f(std::abs(size.x), std::abs(size.y))))
+    , mSkin(std::move(skin))
+    {
+    }
+
+    sf::Sprite Button::sprite(State state) const
+    {
+        sf::Sprite sprite;
+        if (mSkin->texture())
+            sprite.setTexture(*mSkin->texture());
+        sprite.setTextureRect(mSkin->rect(state));
+        sprite.setPosition(collisionShape().getPosition());
+        sprite.setScale(collisionShape().getScale());
+        centerOrigin(sprite);
+        return sprite;
+    }
+
+    const std::shared_ptr<const ButtonSkin>& Button::skin() const
+    {
+        return mSkin;
+    }
+
+    void Button::setHitMask(std::shared_ptr<const HitMask> mask)
+    {
+        mHitMask = std::move(mask);
+    }
+
+    void Button::draw(
+        sf::RenderTarget& target, sf::RenderStates states) const
+    {
+        if (not mSkin->texture())
+            return;
+        const bool ready = loaded(mSkin->texture());
+        const auto color = ready ? sf::Color::White : PlaceholderColor;
+
+        states.transform.translate(collisionShape().getPosition());
+        states.transform.scale(collisionShape().getScale());
+        states.texture = ready ? mSkin->texture() : nullptr;
+
+        if (mSkin->nineSlice())
+        {
+            // Collision rectangle is covered whatever the state rectangle is
+            const auto bounds = collisionShape().getLocalBounds();
+            const auto origin = collisionShape().getOrigin();
+            const auto min = sf::Vector2f(bounds.left, bounds.top) - origin;
+            sf::Vertex quads[9*4];
+            detail::nineSlice(quads, min,
+                              min + sf::Vector2f(bounds.width, bounds.height),
+                              mSkin->rect(state()), mSkin->insets(),
+                              sf::Vector2f(1.f, 1.f), color);
+            target.draw(quads, 9*4, sf::Quads, states);
+            return;
+        }
+
+        // Quad of the state rectangle with origin in it's center
+        // (as ss::centerOrigin sets it), so no sprite is kept per state
+        const auto rect = mSkin->rect(state());
+        const auto size = sf::Vector2f(std::abs(rect.width),
+                                       std::abs(rect.height));
+        const auto origin = sf::Vector2f(
+            static_cast<unsigned>(size.x)/2, static_cast<unsigned>(size.y)/2);
+        sf::Vertex quad[4];
+        detail::frameQuad(quad, -origin, size - origin, rect, color);
+        target.draw(quad, 4, sf::Quads, states);
+    }
+
+    void Button::reportMemory(MemoryReport& report) const
+    {
+        Clickable::reportMemory(report, "ss::Button", sizeof(Button));
+        report.addTexture(mSkin->texture());
+        report.addShared(mSkin.get(), sizeof(ButtonSkin));
+        if (mHitMask)
+            report.addShared(mHitMask.get(),
+                             sizeof(HitMask) + mHitMask->bytes());
+    }
+
+    bool Button::hitTest(sf::Vector2i point) const
+    {
+        if (not Clickable::hitTest(point))
+            return false;
+        if (not mHitMask or mSkin->nineSlice())
+            return true;
+
+        // Point in local coordinates, then in pixels of the idle rectangle
+        const auto local = collisionShape().toLocal(
+            static_cast<sf::Vector2f>(point));
+        const auto rect = mSkin->rect(Idle);
+        const auto x = static_cast<int>(std::floor(local.x));
+        const auto y = static_cast<int>(std::floor(local.y));
+        return mHitMask->opaque(
+            rect.width < 0 ? rect.left - 1 - x : rect.left + x,
+            rect.height < 0 ? rect.top - 1 - y : rect.top + y);
+    }
+
+    Knob::Knob(sf::CircleShape collisionShape, sf::Sprite sprite)
+    : Clickable(std::move(collisionShape))
+    , mSkin(detail::TextureSheet{sprite.getTexture(),
+                                 sprite.getTextureRect(), nullptr})
+    , mValue(0.f)
+    , mPreviousMouseY(0.f)
+    {
+    }
+
+    Knob::Knob(sf::CircleShape collisionShape,
+               std::shared_ptr<const sf::Texture> texture, sf::IntRect sheet)
+    : Clickable(std::move(collisionShape))
+    , mSkin(detail::TextureSheet{texture.get(), sheet, texture})
+    , mValue(0.f)
+    , mPreviousMouseY(0.f)
+    {
+    }
+
+    Knob::Knob(sf::CircleShape collisionShape,
+               std::shared_ptr<StreamingSheet> sheet)
+    : Clickable(std::move(collisionShape))
+    , mSkin(std::move(sheet))
+    , mValue(0.f)
+    , mPreviousMouseY(0.f)
+    {
+    }
+
+    Knob::Knob(sf::CircleShape collisionShape,
+               std::shared_ptr<const CompactSheet> sheet)
+    : Clickable(std::move(collisionShape))
+    , mSkin(std::move(sheet))
+    , mValue(0.f)
+    , mPreviousMouseY(0.f)
+    {
+    }
+
+    Knob::Knob(sf::CircleShape collisionShape, const VectorSkin& skin)
+    : Clickable(std::move(collisionShape))
+    , mSkin(detail::knobGeometry(skin, this->collisionShape().getRadius()))
+    , mValue(0.f)
+    , mPreviousMouseY(0.f)
+    {
+        detail::buildKnobValue(std::get<detail::VectorGeometry>(mSkin),
+                               this->collisionShape().getRadius(), mValue);
+    }
+
+    void Knob::handleEvent(const sf::Event& event)
+    {
+        Clickable::handleEvent(event);
+        const float previousValue = mValue;
+
+        if (state() == Hover
+            and event.type == sf::Event::MouseWheelScrolled
+            and event.mouseWheelScroll.wheel == sf::Mouse::VerticalWheel)
+            mValue +=
+                fmin(event.mouseWheelScroll.delta * KnobScrollSensitivity,
+                     KnobMaxMouseWheelScrollDelta);
+
+        if (state() == Hit and event.type == sf::Event::MouseButtonPressed)
+            mPreviousMouseY = event.mouseButton.y;
+
+        if (state() == Hit and event.type == sf::Event::MouseMoved)
+        {
+            mValue += fmin(
+                (mPreviousMouseY - event.mouseMove.y) * KnobDragSensitivity,
+                KnobMaxMouseMoveDelta);
+            mPreviousMouseY = event.mouseMove.y;
+        }
+
+        mValue = fmax(-1.f, fmin(mValue, 1.f));
+        if (mValue != previousValue)
+            invalidate();
+    }
+
+    void Knob::update(const sf::Window& window)
+    {
+        Clickable::update(window);
+
+        mValue = fmax(-1.f, fmin(mValue, 1.f));
+        const auto vector = std::get_if<detail::VectorGeometry>(&mSkin);
+        if (vector and vector->valueBuilt != mValue)
+            detail::buildKnobValue(*vector, collisionShape().getRadius(),
+                                   mValue);
+    }
+
+    float Knob::value() const
+    {
+        return mValue;
+    }
+
+    void Knob::reportMemory(MemoryReport& report) const
+    {
+        const auto bytes = detail::reportSkin(mSkin, report);
+        Clickable::reportMemory(report, "ss::Knob", sizeof(Knob) + bytes);
+    }
+
+    void Knob::draw(sf::RenderTarget& target, sf::RenderStates states) const
+    {
+        auto skinStates = states;
+        skinStates.transform.translate(getPosition());
+        skinStates.transform.scale(getScale());
+        if (detail::drawSkin(mSkin, mValue, target, skinStates))
+            return;
+
+        auto placeholder = collisionShape();
+        placeholder.setFillColor(PlaceholderColor);
+        target.draw(placeholder, states);
+    }
+
+    void Knob::setValue(float value)
+    {
+        assert(value <= 1.0 and value >= 0.0);
+        mValue = (value-0.5f)*2;
+        invalidate();
+    }
+
+    Slider::Slider()
+    : Clickable(sf::RectangleShape(sf::Vector2f(1.f, 1.f)))
+    , mInitialized(false)
+    {
+    }
+
+    Slider::Slider(sf::RectangleShape collisionShape,
+                    sf::Sprite sprite,
+                    SliderType type)
+    : Clickable(collisionShape)
+    , mInitialized(true)
+    , mValue(0.f)
+    , mSkin(detail::TextureSheet{sprite.getTexture(),
+                                 sprite.getTextureRect(), nullptr})
+    , mType(type)
+    {
+    }
+
+    Slider::Slider(sf::RectangleShape collisionShape,
+                   std::shared_ptr<const sf::Texture> texture,
+                   SliderType type, sf::IntRect sheet)
+    : Clickable(std::move(collisionShape))
+    , mInitialized(true)
+    , mValue(0.f)
+    , mSkin(detail::TextureSheet{texture.get(), sheet, texture})
+    , mType(type)
+    {
+    }
+
+    Slider::Slider(sf::RectangleShape collisionShape,
+                   std::shared_ptr<StreamingSheet> sheet,
+                   SliderType type)
+    : Clickable(std::move(collisionShape))
+    , mInitialized(true)
+    , mValue(0.f)
+    , mSkin(std::move(sheet))
+    , mType(type)
+    {
+    }
+
+    Slider::Slider(sf::RectangleShape collisionShape,
+                   std::shared_ptr<const CompactSheet> sheet,
+                   SliderType type)
+    : Clickable(std::move(collisionShape))
+    , mInitialized(true)
+    , mValue(0.f)
+    , mSkin(std::move(sheet))
+    , mType(type)
+    {
+    }
+
+    Slider::Slider(sf::RectangleShape collisionShape, const VectorSkin& skin,
+                   SliderType type)
+    : Clickable(std::move(collisionShape))
+    , mInitialized(true)
+    , mValue(0.f)
+    , mSkin(detail::sliderGeometry(skin, this->collisionShape().getSize(),
+                                   type))
+    , mType(type)
+    {
+        detail::buildSliderValue(std::get<detail::VectorGeometry>(mSkin),
+                                 this->collisionShape().getSize(), mType,
+                                 mValue);
+    }
+
+    void Slider::handleEvent(const sf::Event& event)
+    {
+        assert(mInitialized);
+        Clickable::handleEvent(event);
+
+        if (state() != Hit)
+            return;
+
+        if (event.type == sf::Event::MouseButtonPressed)
+            track(sf::Vector2i(event.mouseButton.x, event.mouseButton.y));
+        else if (event.type == sf::Event::MouseMoved)
+            track(sf::Vector2i(event.mouseMove.x, event.mouseMove.y));
+    }
+
+    void Slider::update(const sf::Window& window)
+    {
+        assert(mInitialized);
+        Clickable::setPosition(getPosition());
+        Clickable::setScale(getScale());
+        Clickable::update(window);
+
+        mValue = fmax(-1.f, fmin(mValue, 1.f));
+        const auto vector = std::get_if<detail::VectorGeometry>(&mSkin);
+        if (vector and vector->valueBuilt != mValue)
+            detail::buildSliderValue(*vector, collisionShape().getSize(),
+                                     mType, mValue);
+    }
+
+    float Slider::value() const
+    {
+        assert(mInitialized);
+        return mValue;
+    }
+
+    void Slider::setValue(float value)
+    {
+        assert(mInitialized);
+        mValue = value;
+        invalidate();
+    }
+
+    void Slider::track(sf::Vector2i cursor)
+    {
+        const float previousValue = mValue;
+
+        if (mType == Horizontal)
+        {
+            float value
+                = (cursor.x - getPosition().x)
+                / collisionShape().getSize().x;
+            mValue = value*2/getScale().x;
+        }
+        else if (mType == Vertical)
+        {
+            float value
+                = (getPosition().y - cursor.y)
+                / collisionShape().getSize().y;
+            mValue = value*2/getScale().y;
+        }
+
+        mValue = fmax(-1.f, fmin(mValue, 1.f));
+        if (mValue != previousValue)
+            invalidate();
+    }
+
+    void Slider::reportMemory(MemoryReport& report) const
+    {
+        const auto bytes = detail::reportSkin(mSkin, report);
+        Clickable::reportMemory(report, "ss::Slider", sizeof(Slider) + bytes);
+    }
+
+    void Slider::draw(sf::RenderTarget& target, sf::RenderStates states) const
+    {
+        assert(mInitialized);
+        auto skinStates = states;
+        skinStates.transform.translate(getPosition());
+        skinStates.transform.scale(getScale());
+        if (detail::drawSkin(mSkin, mValue, target, skinStates))
+            return;
+
+        auto placeholder = collisionShape();
+        placeholder.setFillColor(PlaceholderColor);
+        target.draw(placeholder, states);
+    }
+
+    LineEdit::LineEdit()
+    : Clickable(sf::RectangleShape(sf::Vector2f(1.f, 1.f)))
+    , mInitialized(false)
+    {
+    }
+
+    LineEdit::LineEdit(sf::RectangleShape collisionShape, sf::Text text)
+    : Clickable(std::move(collisionShape))
+    , mInitialized(true)
+    , mText(std::move(text))
+    {
+    }
+
+    void LineEdit::handleEvent(const sf::Event& event)
+    {
+        assert(mInitialized);
+        Clickable::handleEvent(event);
+        
+        if (state() == Hover)
+        {
+            if (event.type == sf::Event::TextEntered
+                and static_cast<char>(event.text.unicode) >= 32)
+            {
+                mText.setString(mText.getString() + event.text.unicode);
+                invalidate();
+            }
+            if (event.type == sf::Event::KeyPressed)
+            {
+                if (event.key.code == sf::Keyboard::Backspace
+                    and mText.getString().getSize() > 0)
+                {
+                    sf::String string = mText.getString();
+                    string.erase(string.getSize()-1);
+                    mText.setString(std::move(string));
+                    invalidate();
+                }
+            }
+        }
+    }
+
+    void LineEdit::update(const sf::Window& window)
+    {
+        assert(mInitialized);
+        Clickable::setPosition(getPosition());
+        Clickable::setScale(getScale());
+        Clickable::update(window);
+        mText.setPosition(getPosition());
+        mText.setScale(getScale());
+        centerOrigin(mText);
+    }
+
+    void LineEdit::setString(const sf::String& string)
+    {
+        assert(mInitialized);
+        mText.setString(string);
+        invalidate();
+    }
+
+    const sf::String& LineEdit::string() const
+    {
+        assert(mInitialized);
+        return mText.getString();
+    }
+
+    void LineEdit::reportMemory(MemoryReport& report) const
+    {
+        // sf::Text keeps a string and two triangles per character
+        const auto characters = mText.getString().getSize();
+        Clickable::reportMemory(report, "ss::LineEdit", sizeof(LineEdit)
+            + characters * (sizeof(sf::Uint32) + 6*sizeof(sf::Vertex)));
+        report.addGlyphs(mText.getFont(), mText.getCharacterSize());
+    }
+
+    void LineEdit::draw(
+        sf::RenderTarget& target, sf::RenderStates states) const
+    {
+        assert(mInitialized);
+        target.draw(mText, states);
+    }
+
+    RectBatch::RectBatch()
+    : mSize(0)
+    {
+    }
+
+    void RectBatch::push(const sf::FloatRect& rect)
+    {
+        ++mSize;
+        pad();
+        set(mSize-1, rect);
+    }
+
+    void RectBatch::set(std::size_t index, const sf::FloatRect& rect)
+    {
+        assert(index < mSize);
+        mLeft[index] = std::min(rect.left, rect.left + rect.width);
+        mTop[index] = std::min(rect.top, rect.top + rect.height);
+        mRight[index] = std::max(rect.left, rect.left + rect.width);
+        mBottom[index] = std::max(rect.top, rect.top + rect.height);
+    }
+
+    void RectBatch::erase(std::size_t index)
+    {
+        assert(index < mSize);
+        mLeft.erase(mLeft.begin() + index);
+        mTop.erase(mTop.begin() + index);
+        mRight.erase(mRight.begin() + index);
+        mBottom.erase(mBottom.begin() + index);
+        --mSize;
+        pad();
+    }
+
+    void RectBatch::clear()
+    {
+        mSize = 0;
+        pad();
+    }
+
+    std::size_t RectBatch::size() const
+    {
+        return mSize;
+    }
+
+    std::size_t RectBatch::bytes() const
+    {
+        return (mLeft.capacity() + mTop.capacity() + mRight.capacity()
+            + mBottom.capacity()) * sizeof(float);
+    }
+
+    void RectBatch::hitMask(sf::Vector2f point, Mask& mask) const
+    {
+#if defined(SSGUI_AVX) or defined(SSGUI_SSE)
+        mask.assign((mLeft.size() + 63) / 64, 0);
+
+        for (std::size_t i = 0; i < mLeft.size(); i += SimdWidth)
+        {
+#if defined(SSGUI_AVX)
+            const auto x = _mm256_set1_ps(point.x);
+            const auto y = _mm256_set1_ps(point.y);
+            auto in = _mm256_and_ps(
+                _mm256_cmp_ps(_mm256_loadu_ps(&mLeft[i]), x, _CMP_LE_OQ),
+                _mm256_cmp_ps(x, _mm256_loadu_ps(&mRight[i]), _CMP_LT_OQ));
+            in = _mm256_and_ps(in, _mm256_and_ps(
+                _mm256_cmp_ps(_mm256_loadu_ps(&mTop[i]), y, _CMP_LE_OQ),
+                _mm256_cmp_ps(y, _mm256_loadu_ps(&mBottom[i]), _CMP_LT_OQ)));
+            const std::uint64_t bits = _mm256_movemask_ps(in);
+#else
+            const auto x = _mm_set1_ps(point.x);
+            const auto y = _mm_set1_ps(point.y);
+            std::uint64_t bits = 0;
+            for (std::size_t j = 0; j < SimdWidth; j += 4)
+            {
+                auto in = _mm_and_ps(
+                    _mm_cmple_ps(_mm_loadu_ps(&mLeft[i+j]), x),
+                    _mm_cmplt_ps(x, _mm_loadu_ps(&mRight[i+j])));
+                in = _mm_and_ps(in, _mm_and_ps(
+                    _mm_cmple_ps(_mm_loadu_ps(&mTop[i+j]), y),
+                    _mm_cmplt_ps(y, _mm_loadu_ps(&mBottom[i+j]))));
+                bits |= static_cast<std::uint64_t>(_mm_movemask_ps(in)) << j;
+            }
+#endif
+            mask[i / 64] |= bits << (i % 64);
+        }
+
+#ifndef NDEBUG  // Scratch mask keeps its capacity, hit tests don't allocate
+        static thread_local Mask scalar;
+        hitMaskScalar(point, scalar);
+        assert(scalar == mask);
+#endif
+#else
+        hitMaskScalar(point, mask);
+#endif
+    }
+
+    void RectBatch::hitMaskScalar(sf::Vector2f point, Mask& mask) const
+    {
+        mask.assign((mLeft.size() + 63) / 64, 0);
+
+        for (std::size_t i = 0; i < mSize; ++i)
+        {
+            if (mLeft[i] <= point.x and point.x < mRight[i]
+                and mTop[i] <= point.y and point.y < mBottom[i])
+                mask[i / 64] |= std::uint64_t(1) << (i % 64);
+        }
+    }
+
+    void RectBatch::pad()
+    {
+        const auto size = (mSize + SimdWidth - 1) / SimdWidth * SimdWidth;
+        const auto infinity = std::numeric_limits<float>::infinity();
+
+        // Empty rectangle contains nothing
+        mLeft.resize(mSize);
+        mTop.resize(mSize);
+        mRight.resize(mSize);
+        mBottom.resize(mSize);
+        mLeft.resize(size, infinity);
+        mTop.resize(size, infinity);
+        mRight.resize(size, -infinity);
+        mBottom.resize(size, -infinity);
+    }
+
+    EllipseBatch::EllipseBatch()
+    : mSize(0)
+    {
+    }
+
+    void EllipseBatch::push(const Ellipse& ellipse)
+    {
+        ++mSize;
+        pad();
+        set(mSize-1, ellipse);
+    }
+
+    void EllipseBatch::set(std::size_t index, const Ellipse& ellipse)
+    {
+        assert(index < mSize);
+        mCenterX[index] = ellipse.center.x;
+        mCenterY[index] = ellipse.center.y;
+        mInverseRadiusX[index] = 1.f/ellipse.radii.x;
+        mInverseRadiusY[index] = 1.f/ellipse.radii.y;
+    }
+
+    void EllipseBatch::erase(std::size_t index)
+    {
+        assert(index < mSize);
+        mCenterX.erase(mCenterX.begin() + index);
+        mCenterY.erase(mCenterY.begin() + index);
+        mInverseRadiusX.erase(mInverseRadiusX.begin() + index);
+        mInverseRadiusY.erase(mInverseRadiusY.begin() + index);
+        --mSize;
+        pad();
+    }
+
+    void EllipseBatch::clear()
+    {
+        mSize = 0;
+        pad();
+    }
+
+    std::size_t EllipseBatch::size() const
+    {
+        return mSize;
+    }
+
+    std::size_t EllipseBatch::bytes() const
+    {
+        return (mCenterX.capacity() + mCenterY.capacity()
+            + mInverseRadiusX.capacity() + mInverseRadiusY.capacity())
+            * sizeof(float);
+    }
+
+    void EllipseBatch::hitMask(sf::Vector2f point, Mask& mask) const
+    {
+#if defined(SSGUI_AVX) or defined(SSGUI_SSE)
+        mask.assign((mCenterX.size() + 63) / 64, 0);
+
+        for (std::size_t i = 0; i < mCenterX.size(); i += SimdWidth)
+        {
+#if defined(SSGUI_AVX)
+            const auto dx = _mm256_mul_ps(
+                _mm256_sub_ps(_mm256_set1_ps(point.x),
+                              _mm256_loadu_ps(&mCenterX[i])),
+                _mm256_loadu_ps(&mInverseRadiusX[i]));
+            const auto dy = _mm256_mul_ps(
+                _mm256_sub_ps(_mm256_set1_ps(point.y),
+                              _mm256_loadu_ps(&mCenterY[i])),
+                _mm256_loadu_ps(&mInverseRadiusY[i]));
+#ifdef __FMA__
+            const auto sum = _mm256_fmadd_ps(dx, dx, _mm256_mul_ps(dy, dy));
+#else
+            const auto sum = _mm256_add_ps(_mm256_mul_ps(dx, dx),
+                                           _mm256_mul_ps(dy, dy));
+#endif
+            const std::uint64_t bits = _mm256_movemask_ps(
+                _mm256_cmp_ps(sum, _mm256_set1_ps(1.f), _CMP_LT_OQ));
+#else
+            std::uint64_t bits = 0;
+            for (std::size_t j = 0; j < SimdWidth; j += 4)
+            {
+                const auto dx = _mm_mul_ps(
+                    _mm_sub_ps(_mm_set1_ps(point.x),
+                               _mm_loadu_ps(&mCenterX[i+j])),
+                    _mm_loadu_ps(&mInverseRadiusX[i+j]));
+                const auto dy = _mm_mul_ps(
+                    _mm_sub_ps(_mm_set1_ps(point.y),
+                               _mm_loadu_ps(&mCenterY[i+j])),
+                    _mm_loadu_ps(&mInverseRadiusY[i+j]));
+                const auto sum = _mm_add_ps(_mm_mul_ps(dx, dx),
+                                            _mm_mul_ps(dy, dy));
+                bits |= static_cast<std::uint64_t>(_mm_movemask_ps(
+                    _mm_cmplt_ps(sum, _mm_set1_ps(1.f)))) << j;
+            }
+#endif
+            mask[i / 64] |= bits << (i % 64);
+        }
+
+#ifndef NDEBUG  // Scratch mask keeps its capacity, hit tests don't allocate
+        static thread_local Mask scalar;
+        hitMaskScalar(point, scalar);
+        assert(scalar == mask);
+#endif
+#else
+        hitMaskScalar(point, mask);
+#endif
+    }
+
+    void EllipseBatch::hitMaskScalar(sf::Vector2f point, Mask& mask) const
+    {
+        mask.assign((mCenterX.size() + 63) / 64, 0);
+
+        for (std::size_t i = 0; i < mSize; ++i)
+        {
+            const float dx = (point.x - mCenterX[i]) * mInverseRadiusX[i];
+            const float dy = (point.y - mCenterY[i]) * mInverseRadiusY[i];
+#ifdef __FMA__
+            const bool inside = std::fma(dx, dx, dy*dy) < 1.f;
+#else
+            const bool inside = dx*dx + dy*dy < 1.f;
+#endif
+            if (inside)
+                mask[i / 64] |= std::uint64_t(1) << (i % 64);
+        }
+    }
+
+    void EllipseBatch::pad()
+    {
+        const auto size = (mSize + SimdWidth - 1) / SimdWidth * SimdWidth;
+        const auto infinity = std::numeric_limits<float>::infinity();
+
+        // Infinite center and inverse radius give infinite distance
+        mCenterX.resize(mSize);
+        mCenterY.resize(mSize);
+        mInverseRadiusX.resize(mSize);
+        mInverseRadiusY.resize(mSize);
+        mCenterX.resize(size, infinity);
+        mCenterY.resize(size, infinity);
+        mInverseRadiusX.resize(size, infinity);
+        mInverseRadiusY.resize(size, infinity);
+    }
+
+    FrameArena::FrameArena(std::size_t blockSize)
+    : mBlockSize(blockSize)
+    , mCurrent(0)
+    , mOffset(0)
+    , mUsed(0)
+    {
+    }
+
+    void* FrameArena::allocate(std::size_t size, std::size_t alignment)
+    {
+        for (; mCurrent < mBlocks.size(); ++mCurrent, mOffset = 0)
+        {
+            const auto& block = mBlocks[mCurrent];
+            const auto address = reinterpret_cast<std::uintptr_t>(
+                block.data.get()) + mOffset;
+            const auto padding = (alignment - address % alignment)
+                % alignment;
+            if (mOffset + padding + size > block.size)
+                continue;  // The rest of the block is wasted until reset
+
+            const auto result = block.data.get() + mOffset + padding;
+            mOffset += padding + size;
+            mUsed += size;
+            return result;
+        }
+
+        // All blocks are full, alignment padding may be needed in the new one
+        const auto blockSize = std::max(mBlockSize, size + alignment);
+        mBlocks.push_back(Block{std::unique_ptr<std::byte[]>(
+                                    new std::byte[blockSize]),
+                                blockSize});
+        return allocate(size, alignment);
+    }
+
+    void FrameArena::reset()
+    {
+        mCurrent = 0;
+        mOffset = 0;
+        mUsed = 0;
+    }
+
+    std::size_t FrameArena::used() const
+    {
+        return mUsed;
+    }
+
+    std::size_t FrameArena::capacity() const
+    {
+        std::size_t capacity = 0;
+        for (const auto& block : mBlocks)
+            capacity += block.size;
+        return capacity;
+    }
+
+    template <typename T>
+    FrameAllocator<T>::FrameAllocator(FrameArena& arena)
+    : mArena(&arena)
+    {
+    }
+
+    template <typename T>
+    template <typename U>
+    FrameAllocator<T>::FrameAllocator(const FrameAllocator<U>& other)
+    : mArena(&other.arena())
+    {
+    }
+
+    template <typename T>
+    T* FrameAllocator<T>::allocate(std::size_t n)
+    {
+        return static_cast<T*>(mArena->allocate(n*sizeof(T), alignof(T)));
+    }
+
+    template <typename T>
+    void FrameAllocator<T>::deallocate(T*, std::size_t)
+    {
+    }
+
+    template <typename T>
+    FrameArena& FrameAllocator<T>::arena() const
+    {
+        return *mArena;
+    }
+
+    template <typename T, typename U>
+    bool operator==(const FrameAllocator<T>& a, const FrameAllocator<U>& b)
+    {
+        return &a.arena() == &b.arena();
+    }
+
+    template <typename T, typename U>
+    bool operator!=(const FrameAllocator<T>& a, const FrameAllocator<U>& b)
+    {
+        return not (a == b);
+    }
+
+    void MemoryReport::addWidget(const std::string& type, std::size_t bytes)
+    {
+        auto& usage = widgets[type];
+        ++usage.count;
+        usage.bytes += bytes;
+    }
+
+    void MemoryReport::addTexture(const sf::Texture* texture)
+    {
+        if (not texture)
+            return;
+        const auto size = texture->getSize();
+        textures[texture] = std::size_t(size.x) * size.y * 4;
+    }
+
+    void MemoryReport::addGlyphs(const sf::Font* font, unsigned characterSize)
+    {
+        if (not font)
+            return;
+        const auto size = font->getTexture(characterSize).getSize();
+        glyphs[{font, characterSize}] = std::size_t(size.x) * size.y * 4;
+    }
+
+    void MemoryReport::addShared(const void* object, std::size_t bytes)
+    {
+        if (object)
+            shared[object] = bytes;
+    }
+
+    std::size_t MemoryReport::widgetBytes() const
+    {
+        std::size_t bytes = 0;
+        for (const auto& [type, usage] : widgets)
+            bytes += usage.bytes;
+        return bytes;
+    }
+
+    std::size_t MemoryReport::textureBytes() const
+    {
+        std::size_t sum = 0;
+        for (const auto& [texture, bytes] : textures)
+            sum += bytes;
+        return sum;
+    }
+
+    std::size_t MemoryReport::glyphBytes() const
+    {
+        std::size_t sum = 0;
+        for (const auto& [page, bytes] : glyphs)
+            sum += bytes;
+        return sum;
+    }
+
+    std::size_t MemoryReport::sharedBytes() const
+    {
+        std::size_t sum = 0;
+        for (const auto& [object, bytes] : shared)
+            sum += bytes;
+        return sum;
+    }
+
+    std::size_t MemoryReport::totalBytes() const
+    {
+        return widgetBytes() + textureBytes() + glyphBytes() + sharedBytes();
+    }
+
+    Gui::Gui()
+    : mCaptured(nullptr)
+    , mCursor(0, 0)
+    , mCursorInside(false)
+    , mDirty(true)
+    , mUpdateBudget(sf::Time::Zero)
+    , mNext(0)
+    , mMemoryChecked(true)
+    {
+    }
+
+    Gui::~Gui()
+    {
+        for (auto widget : mWidgets)
+            widget->mGui = nullptr;
+    }
+
+    void Gui::add(AbstractWidget& widget)
+    {
+        if (widget.mGui == this)
+            return;
+        if (widget.mGui)
+            widget.mGui->remove(widget);
+
+        widget.mGui = this;
+        widget.mIndex = mWidgets.size();
+        mWidgets.push_back(&widget);
+        mBounds.push(sf::FloatRect());
+        mEllipses.push(Ellipse());
+        invalidateLayout(widget);
+        mDirty = true;
+        mMemoryChecked = false;
+    }
+
+    void Gui::remove(AbstractWidget& widget)
+    {
+        if (widget.mGui != this)
+            return;
+
+        widget.mGui = nullptr;
+        widget.mUrgent = false;
+        mWidgets.erase(mWidgets.begin() + widget.mIndex);
+        mBounds.erase(widget.mIndex);
+        mEllipses.erase(widget.mIndex);
+        for (auto i = widget.mIndex; i < mWidgets.size(); ++i)
+            mWidgets[i]->mIndex = i;
+        mHovered.erase(std::remove(mHovered.begin(), mHovered.end(), &widget),
+                       mHovered.end());
+        mUrgent.erase(std::remove(mUrgent.begin(), mUrgent.end(), &widget),
+                      mUrgent.end());
+        mUpdating.erase(
+            std::remove(mUpdating.begin(), mUpdating.end(), &widget),
+            mUpdating.end());
+        mDirty = true;
+        mMemoryChecked = false;
+        if (mCaptured == &widget)
+            release();
+    }
+
+    void Gui::handleEvent(const sf::Event& event)
+    {
+        if (event.type == sf::Event::MouseMoved)
+        {
+            mCursor = sf::Vector2i(event.mouseMove.x, event.mouseMove.y);
+            mCursorInside = true;
+        }
+        else if (event.type == sf::Event::MouseButtonPressed
+            or event.type == sf::Event::MouseButtonReleased)
+        {
+            mCursor = sf::Vector2i(event.mouseButton.x, event.mouseButton.y);
+        }
+        else if (event.type == sf::Event::MouseLeft)
+        {
+            mCursorInside = false;
+        }
+
+        if (mCaptured and isMouseEvent(event))
+        {
+            mCaptured->handleEvent(event);
+            if (not mCaptured->grabsMouse())
+                release();
+            return;
+        }
+
+        if (event.type == sf::Event::MouseButtonPressed)
+        {
+            // Topmost widget that grabs the mouse takes the press
+            for (auto it = mWidgets.rbegin(); it != mWidgets.rend(); ++it)
+            {
+                (*it)->handleEvent(event);
+                if ((*it)->grabsMouse())
+                {
+                    capture(*it);
+                    break;
+                }
+            }
+            return;
+        }
+
+        if (event.type == sf::Event::MouseMoved)
+        {
+            moveCursor(event);
+            return;
+        }
+
+        for (auto widget : mWidgets)
+            widget->handleEvent(event);
+    }
+
+    void Gui::update(const sf::Window& window)
+    {
+        if (not mMemoryChecked)
+            checkMemoryBudget();
+
+        // Captured widget may be frozen, so it doesn't hold the mouse anymore
+        if (mCaptured and not mCaptured->grabsMouse())
+            release();
+
+        if (mUpdateBudget == sf::Time::Zero)
+        {
+            for (auto widget : mWidgets)
+                widget->update(window);
+            return;
+        }
+
+        sf::Clock clock;
+
+        // First pass: active and invalidated widgets.
+        // Active ones stay queued for the next update
+        mUpdating.swap(mUrgent);
+        for (auto widget : mUpdating)
+            widget->mUrgent = false;
+        while (not mUpdating.empty())
+        {
+            auto widget = mUpdating.back();
+            mUpdating.pop_back();
+            widget->update(window);
+            if (widget->active())
+                enqueue(*widget);
+        }
+
+        // Second pass: round-robin until the budget is spent.
+        // Clock is read once per GuiBudgetCheckInterval widgets
+        // and at least that many widgets are updated every time
+        for (std::size_t i = 0; i < mWidgets.size(); ++i)
+        {
+            if (i and i % GuiBudgetCheckInterval == 0
+                and clock.getElapsedTime() >= mUpdateBudget)
+                break;
+
+            if (mNext >= mWidgets.size())
+                mNext = 0;
+            auto widget = mWidgets[mNext++];
+            if (not widget->mUrgent)
+                widget->update(window);
+        }
+    }
+
+    void Gui::setUpdateBudget(sf::Time budget)
+    {
+        mUpdateBudget = budget;
+    }
+
+    AbstractWidget* Gui::captured() const
+    {
+        return mCaptured;
+    }
+
+    std::optional<sf::Vector2i> Gui::cursorFor(
+                                        const AbstractWidget& widget) const
+    {
+        if (not mCursorInside or (mCaptured and mCaptured != &widget))
+            return std::nullopt;
+        return mCursor;
+    }
+
+    bool Gui::dirty() const
+    {
+        return mDirty;
+    }
+
+    void Gui::invalidate()
+    {
+        mDirty = true;
+    }
+
+    void Gui::validate()
+    {
+        mDirty = false;
+    }
+
+    void Gui::invalidate(AbstractWidget& widget)
+    {
+        mDirty = true;
+        if (widget.active())
+            hover(widget);
+        enqueue(widget);
+    }
+
+    void Gui::enqueue(AbstractWidget& widget)
+    {
+        if (mUpdateBudget != sf::Time::Zero and not widget.mUrgent)
+        {
+            widget.mUrgent = true;
+            mUrgent.push_back(&widget);
+        }
+    }
+
+    bool Gui::animating() const
+    {
+        return std::any_of(mWidgets.begin(), mWidgets.end(),
+            [](const AbstractWidget* widget) { return widget->animating(); });
+    }
+
+    FrameArena& Gui::frameArena()
+    {
+        return mFrameArena;
+    }
+
+    MemoryReport Gui::memoryReport() const
+    {
+        MemoryReport report;
+        for (auto widget : mWidgets)
+            widget->reportMemory(report);
+
+        // Widget pointers, hit test batches and scratch memory
+        report.addWidget("ss::Gui", sizeof(Gui)
+            + (mWidgets.capacity() + mUrgent.capacity()
+               + mUpdating.capacity() + mHovered.capacity()
+               + mWasHovered.capacity())
+              * sizeof(AbstractWidget*)
+            + (mHits.capacity() + mEllipseHits.capacity())
+              * sizeof(std::uint64_t)
+            + mBounds.bytes() + mEllipses.bytes() + mFrameArena.capacity());
+        return report;
+    }
+
+    void Gui::setMemoryBudget(const MemoryBudget& budget)
+    {
+        mMemoryBudget = budget;
+        mMemoryChecked = false;
+    }
+
+    void Gui::invalidateMemory()
+    {
+        mMemoryChecked = false;
+    }
+
+    void Gui::draw(sf::RenderTarget& target, sf::RenderStates states) const
+    {
+        for (auto widget : mWidgets)
+            target.draw(*widget, states);
+    }
+
+    void Gui::invalidateLayout(AbstractWidget& widget)
+    {
+        // Widget is either in mBounds or in mEllipses, other one is empty
+        if (const auto ellipse = widget.ellipse())
+        {
+            mBounds.set(widget.mIndex, sf::FloatRect());
+            mEllipses.set(widget.mIndex, *ellipse);
+        }
+        else
+        {
+            mBounds.set(widget.mIndex, widget.bounds());
+            mEllipses.set(widget.mIndex, Ellipse());
+        }
+    }
+
+    void Gui::moveCursor(const sf::Event& moved)
+    {
+        mBounds.hitMask(sf::Vector2f(mCursor), mHits);
+        mEllipses.hitMask(sf::Vector2f(mCursor), mEllipseHits);
+        for (std::size_t word = 0; word < mHits.size(); ++word)
+            mHits[word] |= mEllipseHits[word];
+
+        // Widgets that become active get back to mHovered by hover()
+        mWasHovered.swap(mHovered);
+        mHovered.clear();
+
+        for (auto widget : mWasHovered)
+        {
+            if (hit(widget->mIndex))
+                continue;  // It gets the event below
+            widget->handleEvent(moved);
+            if (widget->active())
+                hover(*widget);
+        }
+
+        for (std::size_t word = 0; word < mHits.size(); ++word)
+        {
+            if (mHits[word] == 0)
+                continue;
+            for (std::size_t bit = 0; bit < 64; ++bit)
+            {
+                if (not ((mHits[word] >> bit) & 1u))
+                    continue;
+                auto widget = mWidgets[word*64 + bit];
+                widget->handleEvent(moved);
+                if (widget->active())
+                    hover(*widget);
+            }
+        }
+    }
+
+    bool Gui::hit(std::size_t index) const
+    {
+        return index / 64 < mHits.size()
+            and (mHits[index / 64] >> (index % 64)) & 1u;
+    }
+
+    void Gui::hover(AbstractWidget& widget)
+    {
+        if (std::find(mHovered.begin(), mHovered.end(), &widget)
+            == mHovered.end())
+            mHovered.push_back(&widget);
+    }
+
+    void Gui::capture(AbstractWidget* widget)
+    {
+        mCaptured = widget;
+
+        // Other widgets lose hover while the mouse is captured
+        sf::Event left;
+        left.type = sf::Event::MouseLeft;
+        for (auto other : mHovered)
+            if (other != widget)
+                other->handleEvent(left);
+        mHovered.assign(1, widget);
+    }
+
+    void Gui::release()
+    {
+        mCaptured = nullptr;
+
+        if (not mCursorInside)
+            return;
+
+        sf::Event moved;
+        moved.type = sf::Event::MouseMoved;
+        moved.mouseMove.x = mCursor.x;
+        moved.mouseMove.y = mCursor.y;
+        moveCursor(moved);
+    }
+
+    void Gui::checkMemoryBudget()
+    {
+        mMemoryChecked = true;
+
+        const auto& budget = mMemoryBudget;
+        if (not budget.widgets and not budget.textures and not budget.glyphs
+            and not budget.total)
+            return;
+
+        const auto report = memoryReport();
+        const auto check = [](const char* what, std::size_t bytes,
+                              std::size_t limit)
+        {
+            if (limit and bytes > limit)
+                sf::err() << "ssgui: " << what << " memory is " << bytes
+                          << " bytes, budget is " << limit << std::endl;
+        };
+        check("widgets", report.widgetBytes(), budget.widgets);
+        check("textures", report.textureBytes(), budget.textures);
+        check("glyph pages", report.glyphBytes(), budget.glyphs);
+        check("total", report.totalBytes(), budget.total);
+    }
+
+    MemoryOverlay::MemoryOverlay(const Gui& gui, const sf::Font& font,
+                                 unsigned characterSize)
+    : mGui(gui)
+    , mText("", font, characterSize)
+    , mRefreshed(false)
+    {
+    }
+
+    void MemoryOverlay::handleEvent(const sf::Event&)
+    {
+    }
+
+    void MemoryOverlay::update(const sf::Window&)
+    {
+        if (mRefreshed and mClock.getElapsedTime()
+            < sf::milliseconds(MemoryOverlayRefreshMs))
+            return;
+        mRefreshed = true;
+        mClock.restart();
+
+        const auto kb = [](std::size_t bytes)
+        {
+            return std::to_string((bytes + 1023) / 1024) + " KB";
+        };
+
+        const auto report = mGui.memoryReport();
+        std::string text;
+        for (const auto& [type, usage] : report.widgets)
+            text += type + ": " + std::to_string(usage.count) + " x "
+                + std::to_string(usage.bytes / usage.count) + " B = "
+                + kb(usage.bytes) + "\n";
+        for (const auto& [texture, bytes] : report.textures)
+            text += "texture " + std::to_string(texture->getSize().x) + "x"
+                + std::to_string(texture->getSize().y) + ": "
+                + kb(bytes) + "\n";
+        for (const auto& [page, bytes] : report.glyphs)
+            text += "glyphs " + std::to_string(page.second) + "px: "
+                + kb(bytes) + "\n";
+        text += "shared: " + kb(report.sharedBytes()) + "\n";
+        text += "callbacks: " + kb(report.callbackBytes) + "\n";
+        text += "total: " + kb(report.totalBytes());
+
+        if (text != mText.getString().toAnsiString())
+        {
+            mText.setString(text);
+            invalidate();
+        }
+    }
+
+    sf::FloatRect MemoryOverlay::bounds() const
+    {
+        return sf::FloatRect();
+    }
+
+    void MemoryOverlay::reportMemory(MemoryReport& report) const
+    {
+        const auto characters = mText.getString().getSize();
+        report.addWidget("ss::MemoryOverlay", sizeof(MemoryOverlay)
+            + characters * (sizeof(sf::Uint32) + 6*sizeof(sf::Vertex)));
+        report.addGlyphs(mText.getFont(), mText.getCharacterSize());
+    }
+
+    void MemoryOverlay::draw(sf::RenderTarget& target,
+                             sf::RenderStates states) const
+    {
+        states.transform *= getTransform();
+        target.draw(mText, states);
+    }
+
+    ResourceLoader::ResourceLoader(unsigned threads)
+    : mStopping(false)
+    , mRow(0)
+    , mPending(0)
+    {
+        for (unsigned i = 0; i < std::max(threads, 1u); ++i)
+            mWorkers.emplace_back(&ResourceLoader::work, this);
+    }
+
+    ResourceLoader::~ResourceLoader()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            mStopping = true;
+        }
+        mCondition.notify_all();
+        for (auto& worker : mWorkers)
+            worker.join();
+    }
+
+    void ResourceLoader::load(sf::Texture& texture, const std::string& path,
+                              Callback callback)
+    {
+        auto job = std::make_unique<Job>();
+        job->texture = &texture;
+        job->font = nullptr;
+        job->path = path;
+        job->data = nullptr;
+        job->callback = std::move(callback);
+        enqueue(std::move(job));
+    }
+
+    void ResourceLoader::load(sf::Font& font, const std::string& path,
+                              Callback callback)
+    {
+        auto job = std::make_unique<Job>();
+        job->texture = nullptr;
+        job->font = &font;
+        job->path = path;
+        job->data = nullptr;
+        job->callback = std::move(callback);
+        enqueue(std::move(job));
+    }
+
+    void ResourceLoader::load(sf::Texture& texture, const void* data,
+                              std::size_t size, Callback callback)
+    {
+        auto job = std::make_unique<Job>();
+        job->texture = &texture;
+        job->font = nullptr;
+        job->data = data;
+        job->size = size;
+        job->callback = std::move(callback);
+        enqueue(std::move(job));
+    }
+
+    void ResourceLoader::load(sf::Font& font, const void* data,
+                              std::size_t size, Callback callback)
+    {
+        auto job = std::make_unique<Job>();
+        job->texture = nullptr;
+        job->font = &font;
+        job->data = data;
+        job->size = size;
+        job->callback = std::move(callback);
+        enqueue(std::move(job));
+    }
+
+    bool ResourceLoader::upload(std::size_t maxBytes)
+    {
+        bool changed = false;
+        bool first = true;  // The first slice is uploaded in any case
+        while (true)
+        {
+            if (not mUploading)
+            {
+                {
+                    std::lock_guard<std::mutex> lock(mMutex);
+                    if (mDecoded.empty())
+                        break;
+                    mUploading = std::move(mDecoded.front());
+                    mDecoded.pop_front();
+                }
+
+                const auto [w, h] = mUploading->image.getSize();
+                if (mUploading->failed or (mUploading->texture
+                    and (w == 0 or h == 0 or not mStaging.create(w, h))))
+                {
+                    finish();  // Callback sees the resource empty
+                    continue;
+                }
+
+                // Font is ready, it's glyph pages are made when drawn
+                if (mUploading->font)
+                {
+                    *mUploading->font = mUploading->loadedFont;
+                    finish();
+                    changed = true;
+                    continue;
+                }
+
+                mStaging.setSmooth(mUploading->texture->isSmooth());
+                mStaging.setRepeated(mUploading->texture->isRepeated());
+                mRow = 0;
+            }
+
+            const auto [w, h] = mUploading->image.getSize();
+            const auto rowBytes = std::size_t(w) * 4;
+            const auto rows = static_cast<unsigned>(std::min<std::size_t>(
+                h - mRow, std::max<std::size_t>(maxBytes / rowBytes, first)));
+            if (rows == 0)
+                break;
+
+            mStaging.update(mUploading->image.getPixelsPtr()
+                                + mRow*rowBytes, w, rows, 0, mRow);
+            mRow += rows;
+            maxBytes -= std::min(maxBytes, rows*rowBytes);
+            first = false;
+
+            if (mRow == h)
+            {
+                mUploading->texture->swap(mStaging);
+                finish();
+                changed = true;
+            }
+        }
+        return changed;
+    }
+
+    std::size_t ResourceLoader::pending() const
+    {
+        return mPending;
+    }
+
+    void ResourceLoader::enqueue(std::unique_ptr<Job> job)
+    {
+        job->failed = false;
+        ++mPending;
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            mQueue.push_back(std::move(job));
+        }
+        mCondition.notify_one();
+    }
+
+    void ResourceLoader::work()
+    {
+        while (true)
+        {
+            std::unique_ptr<Job> job;
+            {
+                std::unique_lock<std::mutex> lock(mMutex);
+                mCondition.wait(lock,
+                    [this]() { return mStopping or not mQueue.empty(); });
+                if (mStopping)
+                    return;
+                job = std::move(mQueue.front());
+                mQueue.pop_front();
+            }
+
+            if (job->texture and job->data)
+                job->failed = not job->image.loadFromMemory(job->data,
+                                                            job->size);
+            else if (job->texture)
+                job->failed = not job->image.loadFromFile(job->path);
+            else if (job->data)
+                job->failed = not job->loadedFont.loadFromMemory(job->data,
+                                                                 job->size);
+            else
+                job->failed = not job->loadedFont.loadFromFile(job->path);
+
+            std::lock_guard<std::mutex> lock(mMutex);
+            mDecoded.push_back(std::move(job));
+        }
+    }
+
+    void ResourceLoader::finish()
+    {
+        const auto job = std::move(mUploading);
+        --mPending;
+        if (job->callback)
+            job->callback();
+    }
+
+    TextureCache::TextureCache(std::size_t budget)
+    : mUses(0)
+    , mBytes(0)
+    , mBudget(budget)
+    , mLoader(nullptr)
+    {
+    }
+
+    TextureCache::Handle TextureCache::get(const std::string& path)
+    {
+        auto& entry = mEntries[path];
+        if (not entry.texture)
+            entry.texture = std::make_shared<sf::Texture>();
+        entry.lastUse = ++mUses;
+        Handle handle = entry.texture;  // So trim() keeps it
+
+        if (entry.bytes == 0 and not entry.loading)
+        {
+            if (mLoader)
+            {
+                entry.loading = true;
+                mLoader->load(*entry.texture, path, [this, path]()
+                {
+                    // Failed texture accounts nothing and get() retries it
+                    auto& loaded = mEntries[path];
+                    loaded.loading = false;
+                    account(loaded);
+                });
+            }
+            else if (entry.texture->loadFromFile(path))
+                account(entry);
+        }
+        return handle;
+    }
+
+    void TextureCache::setBudget(std::size_t bytes)
+    {
+        mBudget = bytes;
+        trim();
+    }
+
+    void TextureCache::setResourceLoader(ResourceLoader* loader)
+    {
+        mLoader = loader;
+    }
+
+    void TextureCache::trim()
+    {
+        while (mBytes > mBudget)
+        {
+            // Least recently used texture that nobody holds
+            Entry* victim = nullptr;
+            for (auto& [path, entry] : mEntries)
+                if (entry.bytes and entry.texture.use_count() == 1
+                    and (not victim or entry.lastUse < victim->lastUse))
+                    victim = &entry;
+            if (not victim)
+                return;  // Everything loaded is in use
+
+            sf::Texture empty;
+            victim->texture->swap(empty);
+            mBytes -= victim->bytes;
+            victim->bytes = 0;
+        }
+    }
+
+    std::size_t TextureCache::bytes() const
+    {
+        return mBytes;
+    }
+
+    std::size_t TextureCache::loadedCount() const
+    {
+        return std::count_if(mEntries.begin(), mEntries.end(),
+            [](const auto& pair) { return pair.second.bytes != 0; });
+    }
+
+    void TextureCache::reportMemory(MemoryReport& report) const
+    {
+        for (const auto& [path, entry] : mEntries)
+            if (entry.bytes)
+                report.addTexture(entry.texture.get());
+    }
+
+    void TextureCache::account(Entry& entry)
+    {
+        const auto size = entry.texture->getSize();
+        entry.bytes = std::size_t(size.x) * size.y * 4;
+        mBytes += entry.bytes;
+        trim();
+    }
+
+    namespace detail
+    {
+    constexpr std::uint32_t PackVersion = 2;
+
+    // Calls f(i) for every i in [0; count) on up to threads threads,
+    // this thread is one of them
+    template <typename F>
+    void parallelFor(unsigned threads, std::size_t count, F f)
+    {
+        std::atomic<std::size_t> next(0);
+        const auto work = [&]()
+        {
+            for (auto i = next++; i < count; i = next++)
+                f(i);
+        };
+
+        std::vector<std::thread> workers;
+        const auto workerCount = std::min<std::size_t>(
+            std::max(threads, 1u), count);
+        for (std::size_t i = 1; i < workerCount; ++i)
+            workers.emplace_back(work);
+        work();
+        for (auto& worker : workers)
+            worker.join();
+    }
+
+    // Whole file, false if it can't be read
+    bool readFile(const std::string& path, std::vector<char>& bytes)
+    {
+        std::ifstream file(path, std::ios::binary | std::ios::ate);
+        if (not file)
+            return false;
+        bytes.resize(static_cast<std::size_t>(file.tellg()));
+        file.seekg(0);
+        return bool(file.read(bytes.data(), bytes.size()));
+    }
+
+    // Square frames of a vertical spritesheet, zero for empty rectangle
+    unsigned frameCount(sf::IntRect sheet)
+    {
+        if (sheet.width <= 0)
+            return 0;
+        return std::max(sheet.height / sheet.width, 1);
+    }
+
+    // Read-only mapping of a whole file, data is null if it can't be mapped
+    class MappedFile
+    {
+        public:
+            explicit            MappedFile(const std::string& path);
+                                MappedFile(const MappedFile&) = delete;
+                                MappedFile& operator=(
+                                    const MappedFile&) = delete;
+                                ~MappedFile();
+
+
+        public:
+            const std::uint8_t* data() const;
+            std::uint64_t       size() const;
+
+
+        private:
+            const std::uint8_t* mData;
+            std::uint64_t       mSize;
+#ifdef _WIN32
+            HANDLE              mFile;
+            HANDLE              mMapping;
+#endif
+    };
+
+#ifdef _WIN32
+    MappedFile::MappedFile(const std::string& path)
+    : mData(nullptr)
+    , mSize(0)
+    , mFile(CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                        OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr))
+    , mMapping(nullptr)
+    {
+        LARGE_INTEGER size;
+        if (mFile == INVALID_HANDLE_VALUE or not GetFileSizeEx(mFile, &size)
+            or size.QuadPart == 0)
+            return;
+        mMapping = CreateFileMappingA(mFile, nullptr, PAGE_READONLY, 0, 0,
+                                      nullptr);
+        if (not mMapping)
+            return;
+        mData = static_cast<const std::uint8_t*>(
+            MapViewOfFile(mMapping, FILE_MAP_READ, 0, 0, 0));
+        mSize = mData ? size.QuadPart : 0;
+    }
+
+    MappedFile::~MappedFile()
+    {
+        if (mData)
+            UnmapViewOfFile(mData);
+        if (mMapping)
+            CloseHandle(mMapping);
+        if (mFile != INVALID_HANDLE_VALUE)
+            CloseHandle(mFile);
+    }
+#else
+    MappedFile::MappedFile(const std::string& path)
+    : mData(nullptr)
+    , mSize(0)
+    {
+        const int file = open(path.c_str(), O_RDONLY);
+        if (file < 0)
+            return;
+
+        struct stat status;
+        if (fstat(file, &status) == 0 and status.st_size > 0)
+        {
+            // Mapping stays valid when the descriptor is closed
+            const auto data = mmap(nullptr, status.st_size, PROT_READ,
+                                   MAP_PRIVATE, file, 0);
+            if (data != MAP_FAILED)
+            {
+                mData = static_cast<const std::uint8_t*>(data);
+                mSize = status.st_size;
+            }
+        }
+        close(file);
+    }
+
+    MappedFile::~MappedFile()
+    {
+        if (mData)
+            munmap(const_cast<std::uint8_t*>(mData), mSize);
+    }
+#endif
+
+    const std::uint8_t* MappedFile::data() const
+    {
+        return mData;
+    }
+
+    std::uint64_t MappedFile::size() const
+    {
+        return mSize;
+    }
+
+    }  // namespace detail
+
+    Atlas::Atlas()
+    : mTimings{sf::Time::Zero, sf::Time::Zero, sf::Time::Zero}
+    {
+    }
+
+    void Atlas::add(const std::string& name, const std::string& path)
+    {
+        const auto [it, added] = mNames.emplace(name, mEntries.size());
+        if (added)
+            mEntries.push_back(Entry{name, path, 0, sf::IntRect()});
+        else
+            mEntries[it->second].path = path;
+    }
+
+    void Atlas::setCacheDirectory(const std::string& directory)
+    {
+        mCacheDirectory = directory;
+    }
+
+    bool Atlas::build(unsigned threads)
+    {
+        std::vector<std::vector<char>> files;
+        const auto key = read(threads, files);
+
+        // Cached pack of the same files skips decoding and packing
+        std::string cached;
+        if (not mCacheDirectory.empty())
+        {
+            const char digits[] = "0123456789abcdef";
+            cached = mCacheDirectory + "/";
+            for (int shift = 60; shift >= 0; shift -= 4)
+                cached += digits[(key >> shift) & 0xf];
+            cached += ".sspack";
+
+            const auto reading = mTimings.decode;
+            if (readPack(cached))
+            {
+                mTimings.decode += reading;
+                return true;
+            }
+        }
+
+        std::vector<sf::Image> pages;
+        const bool prepared = prepare(threads, files, pages);
+        if (prepared and not cached.empty())
+            writePack(cached, pages);  // Failed builds are not cached
+        upload(pages);
+        return prepared;
+    }
+
+    bool Atlas::savePack(const std::string& path, unsigned threads)
+    {
+        std::vector<std::vector<char>> files;
+        read(threads, files);
+
+        std::vector<sf::Image> pages;
+        const bool prepared = prepare(threads, files, pages);
+        mPages.clear();  // Regions don't match previous pages anymore
+        mTimings.upload = sf::Time::Zero;
+
+        if (not writePack(path, pages))
+        {
+            sf::err() << "ssgui: can't write " << path << std::endl;
+            return false;
+        }
+        return prepared;
+    }
+
+    bool Atlas::loadPack(const std::string& path)
+    {
+        if (readPack(path))
+            return true;
+
+        sf::err() << "ssgui: " << path << " is not a valid pack" << std::endl;
+        return false;
+    }
+
+    std::uint64_t Atlas::read(unsigned threads,
+                              std::vector<std::vector<char>>& files)
+    {
+        sf::Clock clock;
+        files.assign(mEntries.size(), std::vector<char>());
+        std::vector<std::uint64_t> hashes(mEntries.size());
+        detail::parallelFor(threads, mEntries.size(), [&](std::size_t i)
+        {
+            if (not detail::readFile(mEntries[i].path, files[i]))
+                sf::err() << "ssgui: can't read " << mEntries[i].path
+                          << std::endl;
+            hashes[i] = hash64(files[i].data(), files[i].size());
+        });
+
+        // Settings that change the result are a part of the key
+        std::vector<std::uint64_t> key = {
+            detail::PackVersion,
+            AtlasPageSize,
+            sf::Texture::getMaximumSize(),
+            AtlasPadding,
+            HitMaskAlphaThreshold,
+        };
+        for (std::size_t i = 0; i < mEntries.size(); ++i)
+        {
+            const auto& name = mEntries[i].name;
+            key.push_back(hash64(name.data(), name.size()));
+            key.push_back(hashes[i]);
+        }
+
+        mTimings.decode = clock.restart();
+        return hash64(key.data(), key.size()*sizeof(key[0]));
+    }
+
+    bool Atlas::prepare(unsigned threads,
+                        std::vector<std::vector<char>>& files,
+                        std::vector<sf::Image>& pages)
+    {
+        sf::Clock clock;
+
+        // Decode: files are in memory already, so it is cpu work only
+        std::vector<sf::Image> images(mEntries.size());
+        std::atomic<bool> decoded(true);
+        detail::parallelFor(threads, images.size(), [&](std::size_t i)
+        {
+            if (files[i].empty() or not images[i].loadFromMemory(
+                    files[i].data(), files[i].size()))
+                decoded = false;
+            files[i] = std::vector<char>();  // Encoded file is not needed
+        });
+        mTimings.decode += clock.restart();
+
+        // Pack and compose pages on the cpu side
+        std::vector<sf::Vector2u> pageSizes;
+        const bool packed = pack(images, pageSizes);
+
+        pages.assign(pageSizes.size(), sf::Image());
+        for (std::size_t i = 0; i < pages.size(); ++i)
+            pages[i].create(pageSizes[i].x, pageSizes[i].y,
+                            sf::Color::Transparent);
+        for (std::size_t i = 0; i < mEntries.size(); ++i)
+        {
+            const auto& entry = mEntries[i];
+            if (entry.rect.width > 0)
+                pages[entry.page].copy(images[i], entry.rect.left,
+                                       entry.rect.top);
+        }
+
+        mMasks.clear();
+        for (const auto& page : pages)
+            mMasks.push_back(std::make_shared<const HitMask>(page));
+        mTimings.pack = clock.restart();
+
+        return decoded and packed;
+    }
+
+    void Atlas::upload(const std::vector<sf::Image>& pages)
+    {
+        // One pass per page
+        sf::Clock clock;
+        mPages.clear();
+        for (const auto& image : pages)
+        {
+            mPages.push_back(std::make_unique<sf::Texture>());
+            mPages.back()->loadFromImage(image);
+        }
+        mTimings.upload = clock.restart();
+    }
+
+    bool Atlas::writePack(const std::string& path,
+                          const std::vector<sf::Image>& pages)
+    {
+        std::ofstream file(path, std::ios::binary);
+        const auto write = [&file](std::uint64_t value, int bytes=4)
+        {
+            for (int i = 0; i < bytes; ++i)
+                file.put(static_cast<char>(value >> i*8));
+        };
+        const auto padding = [](std::size_t size) { return (4 - size%4)%4; };
+
+        // Data follows the tables, so it's offsets are known in advance
+        std::uint64_t offset = 16 + pages.size()*24;
+        for (const auto& entry : mEntries)
+            offset += 28 + entry.name.size() + padding(entry.name.size());
+
+        file.write("SSPK", 4);
+        write(detail::PackVersion);
+        write(pages.size());
+        write(mEntries.size());
+        for (std::size_t i = 0; i < pages.size(); ++i)
+        {
+            const auto [w, h] = pages[i].getSize();
+            write(w);
+            write(h);
+            write(offset, 8);
+            offset += std::uint64_t(w)*h*4;
+            write(offset, 8);
+            offset += mMasks[i]->mBits.size()*8;
+        }
+        for (const auto& entry : mEntries)
+        {
+            write(entry.page);
+            write(std::uint32_t(entry.rect.left));
+            write(std::uint32_t(entry.rect.top));
+            write(std::uint32_t(entry.rect.width));
+            write(std::uint32_t(entry.rect.height));
+            write(detail::frameCount(entry.rect));
+            write(entry.name.size());
+            file.write(entry.name.data(), entry.name.size());
+            file.write("\0\0\0", padding(entry.name.size()));
+        }
+        for (std::size_t i = 0; i < pages.size(); ++i)
+        {
+            const auto [w, h] = pages[i].getSize();
+            file.write(reinterpret_cast<const char*>(pages[i].getPixelsPtr()),
+                       std::size_t(w)*h*4);
+            for (auto word : mMasks[i]->mBits)
+                write(word, 8);
+        }
+        return bool(file);
+    }
+
+    bool Atlas::readPack(const std::string& path)
+    {
+        sf::Clock clock;
+        const detail::MappedFile file(path);
+        const auto data = file.data();
+        const auto size = file.size();
+        const auto read = [data](std::uint64_t at, int bytes=4)
+        {
+            std::uint64_t value = 0;
+            for (int i = 0; i < bytes; ++i)
+                value |= std::uint64_t(data[at+i]) << i*8;
+            return value;
+        };
+
+        if (not data or size < 16 or std::memcmp(data, "SSPK", 4) != 0
+            or read(4) != detail::PackVersion)
+            return false;
+        const auto pageCount = read(8);
+        const auto entryCount = read(12);
+        if (size < 16 + pageCount*24)
+            return false;
+
+        // Rectangle of a built entry lies within it's page
+        const auto inPage = [&read, pageCount](const Entry& entry)
+        {
+            if (entry.page >= pageCount)
+                return false;
+            const auto page = 16 + entry.page*24;
+            const auto width = static_cast<std::int64_t>(read(page));
+            const auto height = static_cast<std::int64_t>(read(page+4));
+            const auto& rect = entry.rect;
+            return rect.left >= 0 and rect.top >= 0 and rect.height > 0
+                and std::int64_t(rect.left) + rect.width <= width
+                and std::int64_t(rect.top) + rect.height <= height;
+        };
+
+        // Tables are checked before anything is replaced
+        std::vector<Entry> entries;
+        std::map<std::string, std::size_t> names;
+        std::uint64_t at = 16 + pageCount*24;
+        for (std::uint64_t i = 0; i < entryCount; ++i)
+        {
+            if (size < at + 28)
+                return false;
+            Entry entry;
+            entry.page = read(at);
+            entry.rect = sf::IntRect(std::int32_t(read(at+4)),
+                                     std::int32_t(read(at+8)),
+                                     std::int32_t(read(at+12)),
+                                     std::int32_t(read(at+16)));
+            const auto nameSize = read(at+24);
+            at += 28;
+            if (size - at < nameSize
+                or (entry.rect.width > 0 and not inPage(entry)))
+                return false;
+            entry.name.assign(reinterpret_cast<const char*>(data + at),
+                              nameSize);
+            at += nameSize + (4 - nameSize%4)%4;
+
+            // Paths of added files are kept for the next build
+            const auto added = mNames.find(entry.name);
+            if (added != mNames.end())
+                entry.path = mEntries[added->second].path;
+            names.emplace(entry.name, entries.size());
+            entries.push_back(std::move(entry));
+        }
+
+        std::vector<std::shared_ptr<const HitMask>> masks;
+        for (std::uint64_t i = 0; i < pageCount; ++i)
+        {
+            const auto page = 16 + i*24;
+            const sf::Vector2u pageSize(read(page), read(page+4));
+            const auto pixels = read(page+8, 8);
+            const auto mask = read(page+16, 8);
+
+            // A page is a texture, sizes are bounded before they are used
+            const auto maximum = sf::Texture::getMaximumSize();
+            if (pageSize.x == 0 or pageSize.y == 0
+                or pageSize.x > maximum or pageSize.y > maximum)
+                return false;
+            const auto words = (std::uint64_t(pageSize.x)*pageSize.y + 63)/64;
+            if (pixels > size or size - pixels
+                    < std::uint64_t(pageSize.x)*pageSize.y*4
+                or mask > size or size - mask < words*8)
+                return false;
+
+            std::vector<std::uint64_t> bits(words);
+            for (std::uint64_t j = 0; j < words; ++j)
+                bits[j] = read(mask + j*8, 8);
+            masks.push_back(std::shared_ptr<const HitMask>(
+                new HitMask(pageSize, std::move(bits))));
+        }
+        mTimings.decode = clock.restart();
+        mTimings.pack = sf::Time::Zero;
+
+        // Upload: mapped pixels are the texture data
+        mPages.clear();
+        for (std::uint64_t i = 0; i < pageCount; ++i)
+        {
+            const auto page = 16 + i*24;
+            mPages.push_back(std::make_unique<sf::Texture>());
+            if (mPages.back()->create(read(page), read(page+4)))
+                mPages.back()->update(data + read(page+8, 8));
+        }
+        mTimings.upload = clock.restart();
+
+        mEntries = std::move(entries);
+        mNames = std::move(names);
+        mMasks = std::move(masks);
+        return true;
+    }
+
+    sf::Sprite Atlas::sprite(const std::string& name) const
+    {
+        assert(contains(name) and "Image was not added to the atlas");
+        const auto& entry = mEntries[mNames.at(name)];
+        if (entry.rect.width <= 0 or entry.page >= mPages.size())
+            return sf::Sprite();
+        return sf::Sprite(*mPages[entry.page], entry.rect);
+    }
+
+    bool Atlas::contains(const std::string& name) const
+    {
+        return mNames.count(name) != 0;
+    }
+
+    unsigned Atlas::frames(const std::string& name) const
+    {
+        assert(contains(name) and "Image was not added to the atlas");
+        return detail::frameCount(mEntries[mNames.at(name)].rect);
+    }
+
+    std::shared_ptr<const HitMask> Atlas::hitMask(
+        const std::string& name) const
+    {
+        assert(contains(name) and "Image was not added to the atlas");
+        const auto& entry = mEntries[mNames.at(name)];
+        if (entry.rect.width <= 0 or entry.page >= mMasks.size())
+            return nullptr;
+        return mMasks[entry.page];
+    }
+
+    std::size_t Atlas::pageCount() const
+    {
+        return mPages.size();
+    }
+
+    const sf::Texture& Atlas::page(std::size_t index) const
+    {
+        assert(index < mPages.size());
+        return *mPages[index];
+    }
+
+    const Atlas::Timings& Atlas::timings() const
+    {
+        return mTimings;
+    }
+
+    bool Atlas::pack(const std::vector<sf::Image>& images,
+                     std::vector<sf::Vector2u>& pageSizes)
+    {
+        // Pages are large enough for the largest image (a long knob
+        // strip for example) up to the maximum texture size
+        unsigned pageSize = AtlasPageSize;
+        for (const auto& image : images)
+            pageSize = std::max({pageSize, image.getSize().x,
+                                 image.getSize().y});
+        pageSize = std::min(pageSize, sf::Texture::getMaximumSize());
+
+        // Shelves: the tallest images go first, each shelf is filled
+        // left to right and a new page starts when shelves don't fit
+        std::vector<std::size_t> order(images.size());
+        for (std::size_t i = 0; i < order.size(); ++i)
+            order[i] = i;
+        std::stable_sort(order.begin(), order.end(),
+            [&images](std::size_t a, std::size_t b)
+            {
+                return images[a].getSize().y > images[b].getSize().y;
+            });
+
+        bool packed = true;
+        unsigned x = 0, shelfTop = 0, shelfHeight = 0;
+        for (auto i : order)
+        {
+            auto& entry = mEntries[i];
+            entry.rect = sf::IntRect();
+            const auto [w, h] = images[i].getSize();
+            if (w == 0 or h == 0)
+                continue;  // Not decoded, already reported by SFML
+            if (w > pageSize or h > pageSize)
+            {
+                sf::err() << "ssgui: " << entry.path << " is larger than "
+                          << pageSize << "px maximum texture size"
+                          << std::endl;
+                packed = false;
+                continue;
+            }
+
+            if (pageSizes.empty())
+                pageSizes.emplace_back(0, 0);
+            if (x + w > pageSize)
+            {
+                x = 0;
+                shelfTop += shelfHeight + AtlasPadding;
+                shelfHeight = 0;
+            }
+            if (shelfTop + h > pageSize)
+            {
+                pageSizes.emplace_back(0, 0);
+                x = shelfTop = shelfHeight = 0;
+            }
+
+            entry.page = pageSizes.size() - 1;
+            entry.rect = sf::IntRect(x, shelfTop, w, h);
+            auto& size = pageSizes.back();
+            size.x = std::max(size.x, x + w);
+            size.y = std::max(size.y, shelfTop + h);
+            x += w + AtlasPadding;
+            shelfHeight = std::max(shelfHeight, h);
+        }
+        return packed;
+    }
+
+    Application::Application(sf::RenderWindow& window, Gui& gui)
+    : mWindow(window)
+    , mGui(gui)
+    , mEventHandler([](const sf::Event&){})
+    , mClearColor(sf::Color::Black)
+    , mTick(sf::Time::Zero)
+    , mLag(sf::Time::Zero)
+    , mLoader(nullptr)
+    {
+    }
+
+    void Application::run()
+    {
+        mGui.invalidate();  // The first frame is always drawn
+        mTickClock.restart();
+        mLag = sf::Time::Zero;
+
+        while (mWindow.isOpen())
+        {
+            bool busy = processEvents();
+            busy = runTasks() or busy;
+            busy = runTimers() or busy;
+            busy = uploadResources() or busy;
+
+            if (not mWindow.isOpen())
+                break;
+
+            tick();
+            if (mGui.animating())
+            {
+                mGui.invalidate();
+                busy = true;
+            }
+
+            if (mGui.dirty())
+                render();
+            else if (not busy)
+                sleep();
+
+            mGui.frameArena().reset();  // Frame scratch data is not needed
+        }
+    }
+
+    void Application::post(Task task)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mTasksMutex);
+            mTasks.push_back(std::move(task));
+        }
+        mTaskPosted.notify_one();
+    }
+
+    void Application::schedule(sf::Time delay, Task task)
+    {
+        mTimers.push_back(Timer{mClock.getElapsedTime() + delay,
+                                std::move(task)});
+    }
+
+    void Application::setEventHandler(EventHandler handler)
+    {
+        mEventHandler = std::move(handler);
+    }
+
+    void Application::setClearColor(sf::Color color)
+    {
+        mClearColor = color;
+        mGui.invalidate();
+    }
+
+    void Application::setResourceLoader(ResourceLoader* loader)
+    {
+        mLoader = loader;
+    }
+
+    void Application::setTickRate(unsigned ticksPerSecond)
+    {
+        mTick = ticksPerSecond ? sf::seconds(1.f/ticksPerSecond)
+                               : sf::Time::Zero;
+        mLag = sf::Time::Zero;
+    }
+
+    float Application::interpolation() const
+    {
+        return mTick == sf::Time::Zero ? 0.f : mLag / mTick;
+    }
+
+    bool Application::processEvents()
+    {
+        bool processed = false;
+        sf::Event event;
+        while (mWindow.pollEvent(event))
+        {
+            processed = true;
+            if (event.type == sf::Event::Closed)
+                mWindow.close();
+            else if (event.type == sf::Event::Resized
+                or event.type == sf::Event::GainedFocus)
+                mGui.invalidate();  // Window contents may be lost
+
+            mEventHandler(event);
+            mGui.handleEvent(event);
+        }
+        return processed;
+    }
+
+    bool Application::runTasks()
+    {
+        // Tasks are moved out, so mTasks keeps it's capacity
+        FrameVector<Task> tasks(mGui.frameArena());
+        {
+            std::lock_guard<std::mutex> lock(mTasksMutex);
+            tasks.assign(std::make_move_iterator(mTasks.begin()),
+                         std::make_move_iterator(mTasks.end()));
+            mTasks.clear();
+        }
+
+        for (auto& task : tasks)
+            task();
+        return not tasks.empty();
+    }
+
+    bool Application::runTimers()
+    {
+        const auto now = mClock.getElapsedTime();
+        FrameVector<Task> due(mGui.frameArena());
+        for (auto it = mTimers.begin(); it != mTimers.end();)
+        {
+            if (it->deadline <= now)
+            {
+                due.push_back(std::move(it->task));
+                it = mTimers.erase(it);
+            }
+            else
+                ++it;
+        }
+
+        // Timers may schedule new timers, so they are called after the loop
+        for (auto& task : due)
+            task();
+        return not due.empty();
+    }
+
+    bool Application::uploadResources()
+    {
+        if (not mLoader or not mLoader->upload())
+            return false;
+
+        mGui.invalidate();  // Textures are drawn instead of placeholders
+        mGui.invalidateMemory();  // And they are not empty anymore
+        return true;
+    }
+
+    void Application::tick()
+    {
+        if (mTick == sf::Time::Zero)
+        {
+            mGui.update(mWindow);
+            return;
+        }
+
+        mLag += mTickClock.restart();
+        unsigned ticks = 0;
+        while (mLag >= mTick and ticks < ApplicationMaxTicksPerFrame)
+        {
+            mGui.update(mWindow);
+            mLag -= mTick;
+            ++ticks;
+        }
+
+        // Too slow to catch up, the rest of the lag is dropped
+        if (mLag >= mTick)
+            mLag = sf::Time::Zero;
+    }
+
+    void Application::render()
+    {
+        mWindow.clear(mClearColor);
+        mWindow.draw(mGui);
+        mWindow.display();
+        mGui.validate();
+    }
+
+    void Application::sleep()
+    {
+        // SFML 2 waitEvent can not time out and can not be woken up
+        // from another thread (it polls every 10ms itself), so the loop
+        // polls the same way but also wakes up for timers and posts
+        auto timeout = sf::milliseconds(ApplicationIdleSleepMs);
+        const auto now = mClock.getElapsedTime();
+        for (const auto& timer : mTimers)
+            timeout = std::min(timeout, timer.deadline - now);
+        if (timeout <= sf::Time::Zero)
+            return;
+
+        std::unique_lock<std::mutex> lock(mTasksMutex);
+        mTaskPosted.wait_for(lock,
+                             std::chrono::microseconds(
+                                 timeout.asMicroseconds()),
+                             [this]() { return not mTasks.empty(); });
+    }
+
+    WidgetStore::WidgetStore()
+    : mCaptured(NoIndex)
+    , mCursor(0.f, 0.f)
+    , mCursorInside(false)
+    , mPreviousMouseY(0.f)
+    {
+    }
+
+    WidgetStore::Button WidgetStore::createButton(const sf::Sprite& idle,
+                                                  const sf::Sprite& hover,
+                                                  const sf::Sprite& hit)
+    {
+        return createButton(ButtonSkin(idle, hover, hit));
+    }
+
+    WidgetStore::Button WidgetStore::createButton(const ButtonSkin& skin)
+    {
+        const auto rect = skin.rect(Idle);
+        return createButton(skin, sf::Vector2f(std::abs(rect.width),
+                                               std::abs(rect.height)));
+    }
+
+    WidgetStore::Button WidgetStore::createButton(const ButtonSkin& skin,
+                                                  sf::Vector2f size)
+    {
+        const auto index = create(ButtonKind, skin.texture(), size,
+                                  skin.nineSlice() ? 9 : 1);
+        mStateRects[index] = {skin.rect(Idle), skin.rect(Hover),
+                              skin.rect(Hit)};
+        mInsets[index] = skin.insets();
+        return Button(*this, Handle{index, mGenerations[index]});
+    }
+
+    WidgetStore::Knob WidgetStore::createKnob(float radius,
+                                              const sf::Texture& texture,
+                                              sf::IntRect sheet)
+    {
+        const auto index = create(KnobKind, &texture,
+                                  sf::Vector2f(radius*2, radius*2));
+        mStateRects[index][Idle] = sheet;
+        return Knob(*this, Handle{index, mGenerations[index]});
+    }
+
+    WidgetStore::Slider WidgetStore::createSlider(sf::Vector2f size,
+                                                  const sf::Texture& texture,
+                                                  SliderType type,
+                                                  sf::IntRect sheet)
+    {
+        const auto index = create(SliderKind, &texture, size);
+        mSliderTypes[index] = type;
+        mStateRects[index][Idle] = sheet;
+        return Slider(*this, Handle{index, mGenerations[index]});
+    }
+
+    void WidgetStore::destroy(Handle handle)
+    {
+        assert(alive(handle));
+        const auto index = handle.index;
+
+        if (mCaptured == index)
+            mCaptured = NoIndex;
+
+        // Empty shapes and degenerate quads: the slot is skipped by hit
+        // tests and draws nothing until it is reused
+        mKinds[index] = FreeKind;
+        mStates[index] = Idle;
+        mFrozen[index] = 1;
+        mBounds.set(index, sf::FloatRect());
+        mEllipses.set(index, Ellipse());
+        std::fill_n(&mVertices[mFirstVertices[index]], mQuadCounts[index]*4,
+                    sf::Vertex());
+        mTextures[index] = nullptr;
+        mCallbacks[index] = {};  // Releases what callbacks have captured
+        setBit(mHovered, index, false);
+
+        ++mGenerations[index];
+        mFreeSlots.push_back(index);
+        invalidate();
+    }
+
+    bool WidgetStore::alive(Handle handle) const
+    {
+        // Generation of the slot is changed when it's widget is destroyed
+        return handle.index < mGenerations.size()
+            and mGenerations[handle.index] == handle.generation;
+    }
+
+    std::size_t WidgetStore::size() const
+    {
+        return mKinds.size() - mFreeSlots.size();
+    }
+
+    void WidgetStore::handleEvent(const sf::Event& event)
+    {
+        if (event.type == sf::Event::MouseMoved)
+        {
+            mCursor = getInverseTransform().transformPoint(
+                static_cast<float>(event.mouseMove.x),
+                static_cast<float>(event.mouseMove.y));
+            mCursorInside = true;
+
+            // Captured widget is the only one to care about
+            if (mCaptured != NoIndex)
+                drag(mCaptured, mCursor);
+            else
+                moveCursor();
+        }
+        else if (event.type == sf::Event::MouseLeft)
+        {
+            mCursorInside = false;
+            if (mCaptured == NoIndex)
+                moveCursor();
+        }
+        else if (event.type == sf::Event::MouseButtonPressed)
+        {
+            mCursor = getInverseTransform().transformPoint(
+                static_cast<float>(event.mouseButton.x),
+                static_cast<float>(event.mouseButton.y));
+            mCursorInside = true;
+
+            if (mCaptured != NoIndex)
+                return;
+            moveCursor();
+            if (event.mouseButton.button != sf::Mouse::Left)
+                return;
+
+            // Hovered widget in the last slot is on top, it gets hit
+            for (auto word = mHovered.size(); word-- > 0;)
+            {
+                if (mHovered[word] == 0)
+                    continue;
+
+                auto bit = 63u;
+                while (not ((mHovered[word] >> bit) & 1u))
+                    --bit;
+                mCaptured = static_cast<Index>(word*64 + bit);
+                break;
+            }
+            if (mCaptured == NoIndex)
+                return;
+
+            // Other widgets lose hover while the mouse is captured
+            for (std::size_t word = 0; word < mHovered.size(); ++word)
+                for (auto bit = 0u; mHovered[word] and bit < 64; ++bit)
+                {
+                    const auto index = static_cast<Index>(word*64 + bit);
+                    if (index != mCaptured and testBit(mHovered, index))
+                        setState(index, Idle);
+                }
+            if (mCaptured == NoIndex)  // Destroyed by a callback
+                return;
+
+            mPreviousMouseY = mCursor.y;
+            setState(mCaptured, Hit);
+            if (mCaptured != NoIndex and mKinds[mCaptured] == SliderKind)
+                drag(mCaptured, mCursor);
+        }
+        else if (event.type == sf::Event::MouseButtonReleased)
+        {
+            mCursor = getInverseTransform().transformPoint(
+                static_cast<float>(event.mouseButton.x),
+                static_cast<float>(event.mouseButton.y));
+
+            if (mCaptured != NoIndex
+                and event.mouseButton.button == sf::Mouse::Left)
+            {
+                const auto index = mCaptured;
+                mCaptured = NoIndex;
+                setState(index, Hover);
+                moveCursor();  // Mouse may be released outside of widget
+            }
+        }
+        else if (event.type == sf::Event::MouseWheelScrolled)
+        {
+            if (mCaptured != NoIndex
+                or event.mouseWheelScroll.wheel != sf::Mouse::VerticalWheel)
+                return;
+
+            for (std::size_t word = 0; word < mHovered.size(); ++word)
+                for (auto bit = 0u; mHovered[word] and bit < 64; ++bit)
+                {
+                    const auto index = static_cast<Index>(word*64 + bit);
+                    if (not testBit(mHovered, index)
+                        or mKinds[index] != KnobKind)
+                        continue;
+
+                    mValues[index] = fmax(-1.f, fmin(1.f, mValues[index]
+                        + fmin(event.mouseWheelScroll.delta
+                                * KnobScrollSensitivity,
+                               KnobMaxMouseWheelScrollDelta)));
+                    touch(index);
+                }
+        }
+    }
+
+    void WidgetStore::update([[maybe_unused]] const sf::Window& window)
+    {
+        // Placeholders are rebuilt when their textures have been loaded
+        if (not mWaiting.empty())
+        {
+            const auto ready = [this](Index index)
+            {
+                return mKinds[index] == FreeKind
+                    or loaded(mTextures[index]);
+            };
+            for (auto index : mWaiting)
+                if (ready(index))
+                    touch(index);
+            mWaiting.erase(std::remove_if(mWaiting.begin(), mWaiting.end(),
+                                          ready),
+                           mWaiting.end());
+        }
+
+        // Hover changes touch widgets again, so it is done until nothing
+        // changes (the second pass is the last one)
+        while (not mTouchedList.empty())
+        {
+            mUpdating.swap(mTouchedList);
+            mTouchedList.clear();
+
+            for (auto index : mUpdating)
+            {
+                mTouched[index] = 0;
+                if (mKinds[index] == FreeKind)
+                    continue;
+
+                const auto position = mPositions[index];
+                const auto scale = mScales[index];
+                const auto half = sf::Vector2f(
+                    mSizes[index].x * std::abs(scale.x) / 2,
+                    mSizes[index].y * std::abs(scale.y) / 2);
+                if (mKinds[index] == KnobKind)
+                {
+                    mEllipses.set(index, Ellipse{position, half});
+                    mBounds.set(index, sf::FloatRect());
+                }
+                else
+                {
+                    mEllipses.set(index, Ellipse());
+                    mBounds.set(index,
+                                sf::FloatRect(position - half, half*2.f));
+                }
+
+                // Quad is centered like ss::centerOrigin does for sprites,
+                // until texture is loaded it is a plain collision rectangle
+                const bool ready = loaded(mTextures[index]);
+                if (not ready and std::find(mWaiting.begin(), mWaiting.end(),
+                                            index) == mWaiting.end())
+                    mWaiting.push_back(index);
+                const auto color = ready ? sf::Color::White
+                                         : PlaceholderColor;
+                auto quad = &mVertices[mFirstVertices[index]];
+                if (mQuadCounts[index] == 9)
+                {
+                    // Nine-slice button covers it's collision rectangle
+                    const auto area = sf::Vector2f(
+                        mSizes[index].x * scale.x / 2,
+                        mSizes[index].y * scale.y / 2);
+                    detail::nineSlice(quad, position - area,
+                                      position + area, textureRect(index),
+                                      mInsets[index], scale, color);
+                }
+                else
+                {
+                    const auto rect = ready ? textureRect(index)
+                        : sf::IntRect(0, 0, mSizes[index].x, mSizes[index].y);
+                    const auto quadHalf = sf::Vector2f(
+                        std::abs(rect.width) * scale.x / 2,
+                        std::abs(rect.height) * scale.y / 2);
+                    detail::frameQuad(quad, position - quadHalf,
+                                      position + quadHalf, rect, color);
+                }
+
+                // Widget might have been moved under or away from the cursor
+                if (mFrozen[index] or mCaptured != NoIndex
+                    or mStates[index] == Hit)
+                    continue;
+                const bool inside = mCursorInside
+                    and hitTest(index, mCursor);
+                if (inside != (mStates[index] == Hover))
+                    setState(index, inside ? Hover : Idle);
+            }
+        }
+    }
+
+    bool WidgetStore::grabsMouse() const
+    {
+        return mCaptured != NoIndex;
+    }
+
+    void WidgetStore::reportMemory(MemoryReport& report) const
+    {
+        const auto bytes = [](const auto& array)
+        {
+            return array.capacity() * sizeof(array[0]);
+        };
+
+        report.addWidget("ss::WidgetStore", sizeof(WidgetStore)
+            + bytes(mKinds) + bytes(mStates) + bytes(mFrozen)
+            + bytes(mValues) + bytes(mPositions) + bytes(mScales)
+            + bytes(mSizes) + mBounds.bytes() + mEllipses.bytes()
+            + bytes(mVertices) + bytes(mFirstVertices) + bytes(mQuadCounts)
+            + bytes(mTextures) + bytes(mStateRects) + bytes(mSliderTypes)
+            + bytes(mInsets) + bytes(mCallbacks) + bytes(mGenerations)
+            + bytes(mFreeSlots) + bytes(mTouched) + bytes(mTouchedList)
+            + bytes(mUpdating) + bytes(mWaiting) + bytes(mHovered)
+            + bytes(mHits) + bytes(mEllipseHits));
+        report.callbackBytes += bytes(mCallbacks);
+        for (auto texture : mTextures)
+            report.addTexture(texture);
+    }
+
+    bool WidgetStore::active() const
     {
-        mCollisionShape.setPosition(getPosition());
-        mCollisionShape.setScale(getScale());
-        centerOrigin(mCollisionShape);
+        return mCaptured != NoIndex
+            or std::any_of(mHovered.begin(), mHovered.end(),
+                           [](std::uint64_t word) { return word != 0; });
+    }
 
-        if (mFreezed)
+    void WidgetStore::draw(sf::RenderTarget& target,
+                           sf::RenderStates states) const
+    {
+        states.transform *= getTransform();
+
+        // Run of widgets with the same texture and adjacent quads is
+        // a single draw call, free slots have degenerate quads and don't
+        // break the run
+        std::size_t first = 0;
+        while (first < mKinds.size())
+        {
+            if (mKinds[first] == FreeKind)
+            {
+                ++first;
+                continue;
+            }
+
+            const std::size_t begin = mFirstVertices[first];
+            auto end = begin + mQuadCounts[first]*4;
+            auto last = first + 1;
+            while (last < mKinds.size() and mFirstVertices[last] == end
+                and (mTextures[last] == mTextures[first]
+                     or mKinds[last] == FreeKind))
+                end += mQuadCounts[last++]*4;
+
+            states.texture = loaded(mTextures[first]) ? mTextures[first]
+                                                      : nullptr;
+            target.draw(&mVertices[begin], end - begin, sf::Quads, states);
+            first = last;
+        }
+    }
+
+    WidgetStore::Index WidgetStore::create(Kind kind,
+                                            const sf::Texture* texture,
+                                            sf::Vector2f size,
+                                            std::uint8_t quads)
+    {
+        // Quads of a slot never move, so a slot fits widgets with
+        // the same number of quads only
+        const auto free = std::find_if(mFreeSlots.rbegin(), mFreeSlots.rend(),
+            [&](Index index) { return mQuadCounts[index] == quads; });
+        if (free != mFreeSlots.rend())
+        {
+            const auto index = *free;
+            mFreeSlots.erase(std::next(free).base());
+
+            mKinds[index] = kind;
+            mStates[index] = Idle;
+            mFrozen[index] = 0;
+            mValues[index] = 0.f;
+            mPositions[index] = sf::Vector2f(0.f, 0.f);
+            mScales[index] = sf::Vector2f(1.f, 1.f);
+            mSizes[index] = size;
+            mTextures[index] = texture;
+            mStateRects[index] = {};
+            mSliderTypes[index] = Horizontal;
+            mInsets[index] = ButtonSkin::Insets();
+            mCallbacks[index] = {[](){}, [](){}, [](){}};
+
+            touch(index);
+            return index;
+        }
+
+        const auto index = static_cast<Index>(mKinds.size());
+        assert(index != NoIndex);
+
+        mKinds.push_back(kind);
+        mStates.push_back(Idle);
+        mFrozen.push_back(0);
+        mValues.push_back(0.f);
+        mPositions.push_back(sf::Vector2f(0.f, 0.f));
+        mScales.push_back(sf::Vector2f(1.f, 1.f));
+        mSizes.push_back(size);
+        mBounds.push(sf::FloatRect());
+        mEllipses.push(Ellipse());
+        mFirstVertices.push_back(static_cast<std::uint32_t>(mVertices.size()));
+        mQuadCounts.push_back(quads);
+        mVertices.resize(mVertices.size() + quads*4);
+        mTextures.push_back(texture);
+        mStateRects.emplace_back();
+        mSliderTypes.push_back(Horizontal);
+        mInsets.emplace_back();
+        mCallbacks.push_back({[](){}, [](){}, [](){}});
+        mGenerations.push_back(0);
+        mTouched.push_back(0);
+        mHovered.resize((mKinds.size() + 63) / 64, 0);
+
+        touch(index);
+        return index;
+    }
+
+    void WidgetStore::setState(Index index, State state)
+    {
+        if (mStates[index] == state)
             return;
 
-        if (mState == Idle 
-            and contains(mCollisionShape, sf::Mouse::getPosition(window)))
+        mStates[index] = state;
+        setBit(mHovered, index, state == Hover and not mFrozen[index]);
+        touch(index);
+
+        // Callback may destroy it's own widget, so it is taken out while
+        // it runs and is put back only if the widget is still alive
+        // (and the callback didn't bind a new one)
+        const auto which = static_cast<unsigned>(state);
+        const auto generation = mGenerations[index];
+        Callback callback;
+        callback.swap(mCallbacks[index][which]);
+        callback();
+        if (mGenerations[index] == generation
+            and not mCallbacks[index][which])
+            mCallbacks[index][which].swap(callback);
+    }
+
+    void WidgetStore::touch(Index index)
+    {
+        if (not mTouched[index])
         {
-            mState = Hover;
-            call();
+            mTouched[index] = 1;
+            mTouchedList.push_back(index);
+        }
+        invalidate();
+    }
+
+    bool WidgetStore::hitTest(Index index, sf::Vector2f point) const
+    {
+        // The same shapes as update puts to the batches
+        const auto scale = mScales[index];
+        const auto half = sf::Vector2f(
+            mSizes[index].x * std::abs(scale.x) / 2,
+            mSizes[index].y * std::abs(scale.y) / 2);
+        if (mKinds[index] == KnobKind)
+            return contains(Ellipse{mPositions[index], half}, point);
+        return sf::FloatRect(mPositions[index] - half, half*2.f)
+            .contains(point);
+    }
+
+    void WidgetStore::moveCursor()
+    {
+        if (mCursorInside)
+        {
+            mBounds.hitMask(mCursor, mHits);
+            mEllipses.hitMask(mCursor, mEllipseHits);
         }
-        else if (mState == Hover
-            and not contains(mCollisionShape, sf::Mouse::getPosition(window)))
+        else
         {
-            mState = Idle;
-            call();
+            mHits.assign(mHovered.size(), 0);
+            mEllipseHits.assign(mHovered.size(), 0);
+        }
+
+        // Only widgets that have changed their hover are visited
+        for (std::size_t word = 0; word < mHovered.size(); ++word)
+        {
+            const auto hits = mHits[word] | mEllipseHits[word];
+            const auto changed = hits ^ mHovered[word];
+            for (auto bit = 0u; changed >> bit and bit < 64; ++bit)
+            {
+                if (not ((changed >> bit) & 1u))
+                    continue;
+
+                const auto index = static_cast<Index>(word*64 + bit);
+                if (mFrozen[index] or mStates[index] == Hit)
+                    continue;
+                setState(index, (hits >> bit) & 1u ? Hover : Idle);
+            }
         }
     }
 
-    template <typename T>
-    const T& Clickable<T>::collisionShape() const
+    void WidgetStore::drag(Index index, sf::Vector2f cursor)
     {
-        return mCollisionShape;
+        auto& value = mValues[index];
+        const float previousValue = value;
+
+        if (mKinds[index] == KnobKind)
+        {
+            value += fmin((mPreviousMouseY - cursor.y) * KnobDragSensitivity,
+                          KnobMaxMouseMoveDelta);
+            mPreviousMouseY = cursor.y;
+        }
+        else if (mKinds[index] == SliderKind
+            and mSliderTypes[index] == Horizontal)
+        {
+            const float progress = (cursor.x - mPositions[index].x)
+                / mSizes[index].x;
+            value = progress*2/mScales[index].x;
+        }
+        else if (mKinds[index] == SliderKind)
+        {
+            const float progress = (mPositions[index].y - cursor.y)
+                / mSizes[index].y;
+            value = progress*2/mScales[index].y;
+        }
+
+        value = fmax(-1.f, fmin(value, 1.f));
+        if (value != previousValue)
+            touch(index);
     }
 
-    template <typename T>
-    State Clickable<T>::state() const
+    sf::IntRect WidgetStore::textureRect(Index index) const
     {
-        return mState;
+        if (mKinds[index] == ButtonKind)
+            return mStateRects[index][static_cast<unsigned>(mStates[index])];
+
+        // Vertical spritesheet of square frames (as ss::Knob has)
+        if (not loaded(mTextures[index]))
+            return sf::IntRect();
+        return spritesheetFrame(*mTextures[index], mStateRects[index][Idle],
+                                mValues[index]);
     }
 
-    template <typename T>
-    bool Clickable<T>::freezed() const
+    void WidgetStore::setBit(RectBatch::Mask& mask, Index index, bool value)
     {
-        return mFreezed;
+        const auto bit = std::uint64_t(1) << (index % 64);
+        if (value)
+            mask[index / 64] |= bit;
+        else
+            mask[index / 64] &= ~bit;
     }
 
-    template <typename T>
-    const typename Clickable<T>::Callback& Clickable<T>::callback(
-                                                            State state) const
+    bool WidgetStore::testBit(const RectBatch::Mask& mask,
+                              Index index) const
     {
-        return mCallbacks[static_cast<unsigned>(state)];
+        return (mask[index / 64] >> (index % 64)) & 1u;
     }
 
-    template <typename T>
-    void Clickable<T>::draw(
-        [[maybe_unused]] sf::RenderTarget& target,
-        [[maybe_unused]] sf::RenderStates states) const
+    WidgetStore::Widget::Widget(WidgetStore& store, Handle handle)
+    : mStore(&store)
+    , mHandle(handle)
     {
     }
 
-    template <typename T>
-    void Clickable<T>::call()
+    void WidgetStore::Widget::bind(State state, Callback callback)
     {
-        mCallbacks[static_cast<unsigned>(mState)]();
+        mStore->mCallbacks[index()][static_cast<unsigned>(state)]
+            = std::move(callback);
     }
 
-    template <typename T>
-    void centerOrigin(T& object)
+    void WidgetStore::Widget::freeze(State state)
     {
-        const auto rect = object.getLocalBounds();
-        object.setOrigin(   rect.left + static_cast<unsigned>(rect.width)/2,
-                            rect.top  + static_cast<unsigned>(rect.height)/2);
+        const auto i = index();
+        if (mStore->mCaptured == i)
+            mStore->mCaptured = NoIndex;
+
+        mStore->mStates[i] = state;
+        mStore->mFrozen[i] = 1;
+        mStore->setBit(mStore->mHovered, i, false);
+        mStore->touch(i);
     }
 
-    template <typename A, typename B>
-    float distance(A a, B b)
+    void WidgetStore::Widget::unfreeze()
     {
-        return sqrt(pow(a.x-b.x, 2) + pow(a.y-b.y, 2));
+        const auto i = index();
+        auto& state = mStore->mStates[i];
+        mStore->mFrozen[i] = 0;
+
+        // Frozen hit widget was not captured, it can't be released
+        if (state == Hit and mStore->mCaptured != i)
+            state = Idle;
+        mStore->setBit(mStore->mHovered, i, state == Hover);
+        mStore->touch(i);  // Update tests it's hover again
     }
 
-    template <typename T>
-    bool contains(const T& shape, sf::Vector2i point)
+    State WidgetStore::Widget::state() const
     {
-        return shape.getGlobalBounds()
-            .contains(static_cast<sf::Vector2f>(point));
+        return mStore->mStates[index()];
     }
 
-    template <>
-    bool contains<sf::CircleShape>(
-        const sf::CircleShape& shape, sf::Vector2i point)
+    bool WidgetStore::Widget::freezed() const
     {
-        return distance(point, shape.getPosition()) < shape.getRadius();
+        return mStore->mFrozen[index()];
     }
 
-    Button::Button(sf::Sprite idle, sf::Sprite hover, sf::Sprite hit)
-    : Clickable(idle)
-    , mSprites{std::move(idle), std::move(hover), std::move(hit)}
+    void WidgetStore::Widget::setPosition(float x, float y)
     {
+        setPosition(sf::Vector2f(x, y));
     }
 
-    const sf::Sprite& Button::sprite(State state) const
+    void WidgetStore::Widget::setPosition(sf::Vector2f position)
     {
-        return mSprites[static_cast<unsigned>(state)];
+        const auto i = index();
+        mStore->mPositions[i] = position;
+        mStore->touch(i);
     }
 
-    void Button::update(const sf::Window& window)
+    sf::Vector2f WidgetStore::Widget::getPosition() const
     {
-        Clickable::update(window);
-        Clickable::setPosition(getPosition());
-        Clickable::setScale(getScale());
-        for (auto& sprite : mSprites)
-        {
-            sprite.setPosition(getPosition());
-            sprite.setScale(getScale());
-            centerOrigin(sprite);
-        }
+        return mStore->mPositions[index()];
     }
 
-    void Button::draw(
-        sf::RenderTarget& target, sf::RenderStates states) const
+    void WidgetStore::Widget::setScale(float x, float y)
     {
-        target.draw(mSprites[static_cast<unsigned>(state())], states);
+        setScale(sf::Vector2f(x, y));
     }
 
-    Knob::Knob(sf::CircleShape collisionShape, sf::Sprite sprite)
-    : Clickable(std::move(collisionShape))
-    , mSprite(std::move(sprite))
-    , mPreviousMouseY(0.f)
+    void WidgetStore::Widget::setScale(sf::Vector2f scale)
     {
+        const auto i = index();
+        mStore->mScales[i] = scale;
+        mStore->touch(i);
     }
 
-    void Knob::handleEvent(const sf::Event& event)
+    sf::Vector2f WidgetStore::Widget::getScale() const
     {
-        Clickable::handleEvent(event);
+        return mStore->mScales[index()];
+    }
 
-        if (state() == Hover
-            and event.type == sf::Event::MouseWheelScrolled
-            and event.mouseWheelScroll.wheel == sf::Mouse::VerticalWheel)
-            mValue +=
-                fmin(event.mouseWheelScroll.delta * KnobScrollSensitivity,
-                     KnobMaxMouseWheelScrollDelta);
+    WidgetStore::Handle WidgetStore::Widget::handle() const
+    {
+        return mHandle;
+    }
 
-        if (state() == Hit and event.type != sf::Event::MouseButtonPressed)
-            mValue += fmin(
-                (mPreviousMouseY - event.mouseMove.y) * KnobDragSensitivity,
-                KnobMaxMouseMoveDelta);
+    WidgetStore::Index WidgetStore::Widget::index() const
+    {
+        assert(mStore->alive(mHandle) and "Widget was destroyed");
+        return mHandle.index;
+    }
 
-        mValue = fmax(-1.f, fmin(mValue, 1.f));
+    float WidgetStore::Knob::value() const
+    {
+        return mStore->mValues[index()];
     }
 
-    void Knob::update(const sf::Window& window)
+    void WidgetStore::Knob::setValue(float value)
     {
-        Clickable::update(window);
+        assert(value <= 1.0 and value >= 0.0);
+        const auto i = index();
+        mStore->mValues[i] = (value-0.5f)*2;
+        mStore->touch(i);
+    }
 
-        mValue = fmax(-1.f, fmin(mValue, 1.f));
-        mSprite.setTextureRect(textureRect());
-        mSprite.setPosition(getPosition());
-        mSprite.setScale(getScale());
-        centerOrigin(mSprite);
-        mPreviousMouseY = sf::Mouse::getPosition(window).y;
+    float WidgetStore::Slider::value() const
+    {
+        return mStore->mValues[index()];
     }
 
-    float Knob::value() const
+    void WidgetStore::Slider::setValue(float value)
     {
-        return mValue;
+        const auto i = index();
+        mStore->mValues[i] = fmax(-1.f, fmin(value, 1.f));
+        mStore->touch(i);
     }
 
-    void Knob::draw(sf::RenderTarget& target, sf::RenderStates states) const
+    template <typename... Ts>
+    WidgetSet<Ts...>::WidgetSet()
+    : mCapturedType(NoWidget)
+    , mCapturedIndex(0)
+    , mCapturedCount(0)
+    , mCursor(0, 0)
+    , mCursorInside(false)
     {
-        target.draw(mSprite, states);
     }
 
-    sf::IntRect Knob::textureRect()
+    template <typename... Ts>
+    WidgetSet<Ts...>::WidgetSet(const WidgetSet& other)
+    : AbstractWidget(other)
+    , mWidgets(other.mWidgets)
+    , mCapturedType(NoWidget)
+    , mCapturedIndex(0)
+    , mCapturedCount(0)
+    , mCursor(other.mCursor)
+    , mCursorInside(other.mCursorInside)
     {
-        assert(mSprite.getTexture());
-        const auto [w, h] = mSprite.getTexture()->getSize();
-        const auto top = roundf((h/w - 1)*(mValue+1.f)/2)*w;
-        return sf::IntRect(0, top, w, w);
+        forEachType(mWidgets, [this](auto& widgets) { adopt(widgets); });
     }
 
-    void Knob::setValue(float value)
+    template <typename... Ts>
+    WidgetSet<Ts...>& WidgetSet<Ts...>::operator=(const WidgetSet& other)
     {
-        assert(value <= 1.0 and value >= 0.0);
-        mValue = (value-0.5f)*2;
+        AbstractWidget::operator=(other);
+        mWidgets = other.mWidgets;
+        mCapturedType = NoWidget;
+        mCursor = other.mCursor;
+        mCursorInside = other.mCursorInside;
+        forEachType(mWidgets, [this](auto& widgets) { adopt(widgets); });
+        invalidate();
+        return *this;
     }
 
-    Slider::Slider()
-    : Clickable(sf::RectangleShape(sf::Vector2f(1.f, 1.f)))
-    , mInitialized(false)
+    template <typename... Ts>
+    template <typename T>
+    T& WidgetSet<Ts...>::add(T widget)
     {
+        auto& widgets = std::get<std::vector<T>>(mWidgets);
+        const auto capacity = widgets.capacity();
+        widgets.push_back(std::move(widget));
+
+        // Reallocated widgets are copies, they have no owner
+        if (widgets.capacity() != capacity)
+            adopt(widgets);
+        else
+            widgets.back().mOwner = this;
+
+        if (mCapturedType == typeIndex<T>())
+            ++mCapturedCount;
+        invalidate();
+        return widgets.back();
     }
 
-    Slider::Slider(sf::RectangleShape collisionShape,
-                    sf::Sprite sprite,
-                    SliderType type)
-    : Clickable(collisionShape)
-    , mInitialized(true)
-    , mValue(0.f)
-    , mSprite(std::move(sprite))
-    , mType(type)
+    template <typename... Ts>
+    template <typename T>
+    void WidgetSet<Ts...>::erase(std::size_t index)
     {
+        auto& widgets = std::get<std::vector<T>>(mWidgets);
+        assert(index < widgets.size());
+        widgets.erase(widgets.begin() + index);
+        invalidate();
+
+        if (mCapturedType != typeIndex<T>())
+            return;
+        --mCapturedCount;
+        if (mCapturedIndex == index)
+            release();
+        else if (mCapturedIndex > index)
+            --mCapturedIndex;
     }
 
-    void Slider::update(const sf::Window& window)
+    template <typename... Ts>
+    template <typename T>
+    std::vector<T>& WidgetSet<Ts...>::widgets()
     {
-        assert(mInitialized);
-        Clickable::setPosition(getPosition());
-        Clickable::setScale(getScale());
-        Clickable::update(window);
-        mSprite.setPosition(getPosition());
-        mSprite.setScale(getScale());
-        centerOrigin(mSprite);
+        return std::get<std::vector<T>>(mWidgets);
+    }
 
-        if (mType == Horizontal)
+    template <typename... Ts>
+    template <typename T>
+    const std::vector<T>& WidgetSet<Ts...>::widgets() const
+    {
+        return std::get<std::vector<T>>(mWidgets);
+    }
+
+    template <typename... Ts>
+    std::size_t WidgetSet<Ts...>::size() const
+    {
+        return std::apply([](const auto&... widgets)
+            { return (std::size_t(0) + ... + widgets.size()); }, mWidgets);
+    }
+
+    template <typename... Ts>
+    void WidgetSet<Ts...>::handleEvent(const sf::Event& event)
+    {
+        if (event.type == sf::Event::MouseMoved)
         {
-            if (state() == Hit)
-            {
-                float value
-                    = (sf::Mouse::getPosition(window).x - getPosition().x)
-                    / collisionShape().getSize().x;
-                mValue = value*2/getScale().x;
-            }
+            mCursor = sf::Vector2i(event.mouseMove.x, event.mouseMove.y);
+            mCursorInside = true;
         }
-        else if (mType == Vertical)
+        else if (event.type == sf::Event::MouseButtonPressed
+            or event.type == sf::Event::MouseButtonReleased)
+        {
+            mCursor = sf::Vector2i(event.mouseButton.x, event.mouseButton.y);
+        }
+        else if (event.type == sf::Event::MouseLeft)
+        {
+            mCursorInside = false;
+        }
+
+        const auto handle = [&event](auto& widget)
+        {
+            using T = std::decay_t<decltype(widget)>;
+            widget.T::handleEvent(event);
+        };
+
+        if (mCapturedType != NoWidget and captured() == NoWidget)
+            release();  // Captured widget can't be found anymore
+
+        if (mCapturedType != NoWidget and isMouseEvent(event))
+        {
+            const auto index = captured();
+            visit(mWidgets, index, handle);
+            if (not grabs(index))
+                release();
+            return;
+        }
+
+        if (event.type == sf::Event::MouseButtonPressed)
         {
-            if (state() == Hit)
+            // Topmost widget that grabs the mouse takes the press
+            for (auto index = size(); index-- > 0;)
             {
-                float value
-                    = (getPosition().y - sf::Mouse::getPosition(window).y)
-                    / collisionShape().getSize().y;
-                mValue = value*2/getScale().y;
+                visit(mWidgets, index, handle);
+                if (grabs(index))
+                {
+                    capture(index);
+                    break;
+                }
             }
+            return;
         }
 
-        mValue = fmax(-1.f, fmin(mValue, 1.f));
+        forEachType(mWidgets, [&handle](auto& widgets)
+        {
+            for (auto& widget : widgets)
+                handle(widget);
+        });
+    }
+
+    template <typename... Ts>
+    void WidgetSet<Ts...>::update(const sf::Window& window)
+    {
+        // Captured widget may be frozen or erased, it doesn't hold
+        // the mouse anymore
+        if (mCapturedType != NoWidget and not grabs(captured()))
+            release();
 
-        const auto [w, h] = mSprite.getTexture()->getSize();
-        const auto top = roundf((h/w - 1)*(mValue+1.f)/2)*w;
-        mSprite.setTextureRect(sf::IntRect(0, top, w, w));
+        forEachType(mWidgets, [&window](auto& widgets)
+        {
+            using T = typename std::decay_t<decltype(widgets)>::value_type;
+            for (auto& widget : widgets)
+                widget.T::update(window);
+        });
     }
 
-    float Slider::value() const
+    template <typename... Ts>
+    bool WidgetSet<Ts...>::grabsMouse() const
     {
-        assert(mInitialized);
-        return mValue;
+        return mCapturedType != NoWidget and grabs(captured());
     }
 
-    void Slider::setValue(float value)
+    template <typename... Ts>
+    void WidgetSet<Ts...>::reportMemory(MemoryReport& report) const
     {
-        assert(mInitialized);
-        mValue = value;
+        report.addWidget("ss::WidgetSet", sizeof(WidgetSet));
+        forEachType(mWidgets, [&report](const auto& widgets)
+        {
+            using T = typename std::decay_t<decltype(widgets)>::value_type;
+            for (const auto& widget : widgets)
+                widget.T::reportMemory(report);
+        });
     }
 
-    void Slider::draw(sf::RenderTarget& target, sf::RenderStates states) const
+    template <typename... Ts>
+    bool WidgetSet<Ts...>::animating() const
     {
-        assert(mInitialized);
-        target.draw(mSprite, states);
+        bool animating = false;
+        forEachType(mWidgets, [&animating](const auto& widgets)
+        {
+            using T = typename std::decay_t<decltype(widgets)>::value_type;
+            animating = animating or std::any_of(widgets.begin(),
+                widgets.end(),
+                [](const T& widget) { return widget.T::animating(); });
+        });
+        return animating;
     }
 
-    LineEdit::LineEdit()
-    : Clickable(sf::RectangleShape(sf::Vector2f(1.f, 1.f)))
-    , mInitialized(false)
+    template <typename... Ts>
+    void WidgetSet<Ts...>::draw(sf::RenderTarget& target,
+                                sf::RenderStates states) const
     {
+        forEachType(mWidgets, [&target, &states](const auto& widgets)
+        {
+            using T = typename std::decay_t<decltype(widgets)>::value_type;
+            for (const auto& widget : widgets)
+                widget.T::draw(target, states);
+        });
     }
 
-    LineEdit::LineEdit(sf::RectangleShape collisionShape, sf::Text text)
-    : Clickable(std::move(collisionShape))
-    , mInitialized(true)
-    , mText(std::move(text))
+    template <typename... Ts>
+    template <typename Tuple, typename F>
+    void WidgetSet<Ts...>::forEachType(Tuple& widgets, F function)
     {
+        std::apply([&function](auto&... vectors) { (function(vectors), ...); },
+                   widgets);
     }
 
-    void LineEdit::handleEvent(const sf::Event& event)
+    template <typename... Ts>
+    template <typename Tuple, typename F>
+    void WidgetSet<Ts...>::visit(Tuple& widgets, std::size_t index,
+                                 F function)
     {
-        assert(mInitialized);
-        Clickable::handleEvent(event);
-        
-        if (state() == Hover)
+        forEachType(widgets, [&index, &function](auto& vector)
         {
-            if (event.type == sf::Event::TextEntered
-                and static_cast<char>(event.text.unicode) >= 32)
-            {
-                mText.setString(mText.getString() + event.text.unicode);
-            }
-            if (event.type == sf::Event::KeyPressed)
-            {
-                if (event.key.code == sf::Keyboard::Backspace
-                    and mText.getString().getSize() > 0)
-                {
-                    sf::String string = mText.getString();
-                    string.erase(string.getSize()-1);
-                    mText.setString(std::move(string));
-                }
-            }
-        }
+            if (index < vector.size())
+                function(vector[index]);
+            index = index < vector.size() ? NoWidget
+                                          : index - vector.size();
+        });
     }
 
-    void LineEdit::update(const sf::Window& window)
+    template <typename... Ts>
+    template <typename T>
+    constexpr std::size_t WidgetSet<Ts...>::typeIndex()
     {
-        assert(mInitialized);
-        Clickable::setPosition(getPosition());
-        Clickable::setScale(getScale());
-        Clickable::update(window);
-        mText.setPosition(getPosition());
-        mText.setScale(getScale());
-        centerOrigin(mText);
+        constexpr bool same[] = {std::is_same_v<T, Ts>...};
+        for (std::size_t i = 0; i < sizeof...(Ts); ++i)
+            if (same[i])
+                return i;
+        return NoWidget;
     }
 
-    void LineEdit::setString(const sf::String& string)
+    template <typename... Ts>
+    std::size_t WidgetSet<Ts...>::captured() const
     {
-        assert(mInitialized);
-        mText.setString(string);
+        auto index = NoWidget;
+        std::size_t type = 0;
+        std::size_t before = 0;  // Widgets of the types before it
+        forEachType(mWidgets, [&](const auto& widgets)
+        {
+            if (type == mCapturedType and widgets.size() == mCapturedCount)
+                index = before + mCapturedIndex;
+            before += widgets.size();
+            ++type;
+        });
+        return index;
     }
 
-    const sf::String& LineEdit::string() const
+    template <typename... Ts>
+    bool WidgetSet<Ts...>::grabs(std::size_t index) const
     {
-        assert(mInitialized);
-        return mText.getString();
+        bool grabs = false;  // Index is out of range if widget was erased
+        visit(mWidgets, index, [&grabs](const auto& widget)
+        {
+            using T = std::decay_t<decltype(widget)>;
+            grabs = widget.T::grabsMouse();
+        });
+        return grabs;
     }
 
-    void LineEdit::draw(
-        sf::RenderTarget& target, sf::RenderStates states) const
+    template <typename... Ts>
+    void WidgetSet<Ts...>::capture(std::size_t index)
     {
-        assert(mInitialized);
-        target.draw(mText, states);
+        std::size_t type = 0;
+        std::size_t rest = index;
+        forEachType(mWidgets, [&](const auto& widgets)
+        {
+            if (rest < widgets.size())
+            {
+                mCapturedType = type;
+                mCapturedIndex = rest;
+                mCapturedCount = widgets.size();
+            }
+            rest = rest < widgets.size() ? NoWidget : rest - widgets.size();
+            ++type;
+        });
+
+        // Other widgets lose hover while the mouse is captured
+        sf::Event left;
+        left.type = sf::Event::MouseLeft;
+        std::size_t other = 0;
+        forEachType(mWidgets, [&](auto& widgets)
+        {
+            using T = typename std::decay_t<decltype(widgets)>::value_type;
+            for (auto& widget : widgets)
+                if (other++ != index)
+                    widget.T::handleEvent(left);
+        });
+    }
+
+    template <typename... Ts>
+    void WidgetSet<Ts...>::release()
+    {
+        mCapturedType = NoWidget;
+
+        if (not mCursorInside)
+            return;
+
+        sf::Event moved;
+        moved.type = sf::Event::MouseMoved;
+        moved.mouseMove.x = mCursor.x;
+        moved.mouseMove.y = mCursor.y;
+        forEachType(mWidgets, [&moved](auto& widgets)
+        {
+            using T = typename std::decay_t<decltype(widgets)>::value_type;
+            for (auto& widget : widgets)
+                widget.T::handleEvent(moved);
+        });
+    }
+
+    template <typename... Ts>
+    template <typename T>
+    void WidgetSet<Ts...>::adopt(std::vector<T>& widgets)
+    {
+        for (auto& widget : widgets)
+            widget.mOwner = this;
     }
 }
 
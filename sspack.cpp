@@ -0,0 +1,39 @@
+#define SSGUI_IMPL
+#include "ssgui.hpp"
+
+#include <iostream>
+
+// sspack - offline packer of skins to a pack for ss::Atlas::loadPack
+// Usage: sspack <output pack> <name>=<image file>...
+// Example: sspack skins.sspack knob=./knobTexture.png
+//                 button=./buttonTexture.png
+
+
+int main(int argc, char** argv)
+{
+    if (argc < 3)
+    {
+        std::cerr << "Usage: " << argv[0]
+                  << " <output pack> <name>=<image file>..." << std::endl;
+        return 1;
+    }
+
+    ss::Atlas atlas;
+    for (int i = 2; i < argc; ++i)
+    {
+        const std::string skin = argv[i];
+        const auto separator = skin.find('=');
+        if (separator == std::string::npos or separator == 0)
+        {
+            std::cerr << "Expected <name>=<image file>: " << skin << std::endl;
+            return 1;
+        }
+        atlas.add(skin.substr(0, separator), skin.substr(separator + 1));
+    }
+
+    const bool saved = atlas.savePack(argv[1]);
+    const auto& timings = atlas.timings();
+    std::cout << "decode " << timings.decode.asMilliseconds() << " ms, "
+              << "pack " << timings.pack.asMilliseconds() << " ms" << std::endl;
+    return saved ? 0 : 1;
+}